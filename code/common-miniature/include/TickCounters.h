@@ -0,0 +1,90 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef COMMON_MINIATURE_TICKCOUNTERS_H
+#define COMMON_MINIATURE_TICKCOUNTERS_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace opendlv {
+namespace common {
+namespace miniature {
+
+/**
+ * Counts how the ticks of a module fit in its timeslice: the time spent
+ * computing each tick, the time waited for the next one, the ticks that
+ * took longer than the period, and the messages received and sent. The
+ * times are counted in fixed histograms spanning two periods, so that 
+ * nothing is allocated while running.
+ */
+class TickCounters {
+ public:
+  TickCounters(double const, uint32_t const);
+  TickCounters(TickCounters const &) = delete;
+  TickCounters &operator=(TickCounters const &) = delete;
+  virtual ~TickCounters();
+
+  void BeginTick();
+  void EndTick();
+  void AddTick(double const, double const);
+  void AddMessagesIn(uint32_t const);
+  void AddMessagesOut(uint32_t const);
+  void Reset();
+  double GetBinWidth() const;
+  uint32_t GetTicks() const;
+  uint32_t GetOverruns() const;
+  uint32_t GetMessagesIn() const;
+  uint32_t GetMessagesOut() const;
+  double GetMeanComputeTime() const;
+  double GetMaxComputeTime() const;
+  double GetMeanWaitTime() const;
+  double GetComputeTimePercentile(double const) const;
+  std::vector<uint32_t> const &GetComputeTimes() const;
+  std::vector<uint32_t> const &GetWaitTimes() const;
+  void WriteCsv(std::ostream &, double const) const;
+
+  static void WriteCsvHeader(std::ostream &);
+
+ private:
+  uint32_t GetBin(double const) const;
+
+  double m_period;
+  double m_binWidth;
+  uint32_t m_ticks;
+  uint32_t m_overruns;
+  uint32_t m_messagesIn;
+  uint32_t m_messagesOut;
+  double m_computeTimeSum;
+  double m_computeTimeMax;
+  double m_waitTimeSum;
+  std::vector<uint32_t> m_computeTimes;
+  std::vector<uint32_t> m_waitTimes;
+  std::chrono::steady_clock::time_point m_tickBegin;
+  std::chrono::steady_clock::time_point m_tickEnd;
+  bool m_hasTickEnd;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,220 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#include <algorithm>
+#include <chrono>
+#include <ostream>
+#include <vector>
+
+#include "TickCounters.h"
+
+namespace opendlv {
+namespace common {
+namespace miniature {
+
+/**
+ * The histograms get the given number of bins over two periods, in 
+ * seconds.
+ */
+TickCounters::TickCounters(double const a_period, uint32_t const a_binCount)
+    : m_period(a_period)
+    , m_binWidth(2.0 * a_period / std::max(a_binCount, 1u))
+    , m_ticks(0)
+    , m_overruns(0)
+    , m_messagesIn(0)
+    , m_messagesOut(0)
+    , m_computeTimeSum(0.0)
+    , m_computeTimeMax(0.0)
+    , m_waitTimeSum(0.0)
+    , m_computeTimes(std::max(a_binCount, 1u), 0)
+    , m_waitTimes(std::max(a_binCount, 1u), 0)
+    , m_tickBegin()
+    , m_tickEnd()
+    , m_hasTickEnd(false)
+{
+}
+
+TickCounters::~TickCounters()
+{
+}
+
+/**
+ * Called when the module wakes up for a tick. The time since the previous
+ * tick ended is what the module waited.
+ */
+void TickCounters::BeginTick()
+{
+  m_tickBegin = std::chrono::steady_clock::now();
+}
+
+void TickCounters::EndTick()
+{
+  std::chrono::steady_clock::time_point const now = 
+      std::chrono::steady_clock::now();
+  double const computeTime = 
+      std::chrono::duration<double>(now - m_tickBegin).count();
+  double const waitTime = m_hasTickEnd 
+      ? std::chrono::duration<double>(m_tickBegin - m_tickEnd).count() 
+      : 0.0;
+  AddTick(computeTime, waitTime);
+  m_tickEnd = now;
+  m_hasTickEnd = true;
+}
+
+/**
+ * Counts a tick from its compute and wait time, in seconds. A tick that 
+ * computes for longer than the period is an overrun.
+ */
+void TickCounters::AddTick(double const a_computeTime, 
+    double const a_waitTime)
+{
+  m_ticks++;
+  if (a_computeTime > m_period) {
+    m_overruns++;
+  }
+  m_computeTimeSum += a_computeTime;
+  m_computeTimeMax = std::max(m_computeTimeMax, a_computeTime);
+  m_waitTimeSum += a_waitTime;
+  m_computeTimes[GetBin(a_computeTime)]++;
+  m_waitTimes[GetBin(a_waitTime)]++;
+}
+
+void TickCounters::AddMessagesIn(uint32_t const a_count)
+{
+  m_messagesIn += a_count;
+}
+
+void TickCounters::AddMessagesOut(uint32_t const a_count)
+{
+  m_messagesOut += a_count;
+}
+
+/**
+ * Starts counting again, but keeps the end of the last tick so that the 
+ * next wait is still measured.
+ */
+void TickCounters::Reset()
+{
+  m_ticks = 0;
+  m_overruns = 0;
+  m_messagesIn = 0;
+  m_messagesOut = 0;
+  m_computeTimeSum = 0.0;
+  m_computeTimeMax = 0.0;
+  m_waitTimeSum = 0.0;
+  std::fill(m_computeTimes.begin(), m_computeTimes.end(), 0);
+  std::fill(m_waitTimes.begin(), m_waitTimes.end(), 0);
+}
+
+double TickCounters::GetBinWidth() const
+{
+  return m_binWidth;
+}
+
+uint32_t TickCounters::GetTicks() const
+{
+  return m_ticks;
+}
+
+uint32_t TickCounters::GetOverruns() const
+{
+  return m_overruns;
+}
+
+uint32_t TickCounters::GetMessagesIn() const
+{
+  return m_messagesIn;
+}
+
+uint32_t TickCounters::GetMessagesOut() const
+{
+  return m_messagesOut;
+}
+
+double TickCounters::GetMeanComputeTime() const
+{
+  return (m_ticks > 0) ? m_computeTimeSum / m_ticks : 0.0;
+}
+
+double TickCounters::GetMaxComputeTime() const
+{
+  return m_computeTimeMax;
+}
+
+double TickCounters::GetMeanWaitTime() const
+{
+  return (m_ticks > 0) ? m_waitTimeSum / m_ticks : 0.0;
+}
+
+/**
+ * Returns the upper edge of the bin holding the given share of the compute
+ * times, or the longest compute time if that is in the last bin.
+ */
+double TickCounters::GetComputeTimePercentile(double const a_share) const
+{
+  uint32_t count = 0;
+  for (uint32_t i = 0; i + 1 < m_computeTimes.size(); i++) {
+    count += m_computeTimes[i];
+    if (count > 0 && count >= a_share * m_ticks) {
+      return (i + 1) * m_binWidth;
+    }
+  }
+  return m_computeTimeMax;
+}
+
+std::vector<uint32_t> const &TickCounters::GetComputeTimes() const
+{
+  return m_computeTimes;
+}
+
+std::vector<uint32_t> const &TickCounters::GetWaitTimes() const
+{
+  return m_waitTimes;
+}
+
+void TickCounters::WriteCsvHeader(std::ostream &a_out)
+{
+  a_out << "time,ticks,overruns,messagesIn,messagesOut,meanComputeTime,"
+      << "computeTime99,maxComputeTime,meanWaitTime" << std::endl;
+}
+
+/**
+ * Writes the counters as one row, at the given time in seconds.
+ */
+void TickCounters::WriteCsv(std::ostream &a_out, double const a_time) const
+{
+  a_out << a_time << "," << m_ticks << "," << m_overruns << "," 
+      << m_messagesIn << "," << m_messagesOut << "," << GetMeanComputeTime()
+      << "," << GetComputeTimePercentile(0.99) << "," << m_computeTimeMax 
+      << "," << GetMeanWaitTime() << std::endl;
+}
+
+uint32_t TickCounters::GetBin(double const a_time) const
+{
+  if (!(a_time > 0.0)) {
+    return 0;
+  }
+  double const bin = a_time / m_binWidth;
+  uint32_t const last = static_cast<uint32_t>(m_computeTimes.size() - 1);
+  return (bin < last) ? static_cast<uint32_t>(bin) : last;
+}
+
+}
+}
+}
@@ -0,0 +1,136 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef COMMON_MINIATURE_TEMPORARYDIRECTORY_H
+#define COMMON_MINIATURE_TEMPORARYDIRECTORY_H
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace opendlv {
+namespace common {
+namespace miniature {
+
+/**
+ * A directory under /tmp standing in for the sysfs files of a proxy in the
+ * test suites. The files and subdirectories it knows of are removed with
+ * it, files first and subdirectories in the reverse order they were made.
+ */
+class TemporaryDirectory {
+ public:
+  TemporaryDirectory(std::string const &a_prefix)
+    : m_path()
+    , m_files()
+    , m_directories()
+  {
+    std::string directoryTemplate = "/tmp/" + a_prefix + "XXXXXX";
+    std::vector<char> buffer(directoryTemplate.begin(),
+        directoryTemplate.end());
+    buffer.push_back('\0');
+    char const *path = mkdtemp(buffer.data());
+    if (path != nullptr) {
+      m_path = path;
+    }
+  }
+
+  TemporaryDirectory(TemporaryDirectory const &) = delete;
+  TemporaryDirectory &operator=(TemporaryDirectory const &) = delete;
+
+  virtual ~TemporaryDirectory()
+  {
+    for (std::string const &file : m_files) {
+      unlink(file.c_str());
+    }
+    for (auto it = m_directories.rbegin(); it != m_directories.rend(); it++) {
+      rmdir(it->c_str());
+    }
+    if (!m_path.empty()) {
+      rmdir(m_path.c_str());
+    }
+  }
+
+  std::string const &GetPath() const
+  {
+    return m_path;
+  }
+
+  /**
+   * Makes a subdirectory, and returns its path.
+   */
+  std::string MakeDirectory(std::string const &a_name)
+  {
+    std::string const path = m_path + "/" + a_name;
+    mkdir(path.c_str(), 0755);
+    m_directories.push_back(path);
+    return path;
+  }
+
+  /**
+   * Writes a file, and returns its path.
+   */
+  std::string WriteFile(std::string const &a_name,
+      std::string const &a_contents)
+  {
+    std::string const path = AddFile(a_name);
+    std::ofstream file(path);
+    file << a_contents;
+    return path;
+  }
+
+  /**
+   * Makes a file created by the code under test known, so that it is
+   * removed, and returns its path.
+   */
+  std::string AddFile(std::string const &a_name)
+  {
+    std::string const path = m_path + "/" + a_name;
+    for (std::string const &file : m_files) {
+      if (file == path) {
+        return path;
+      }
+    }
+    m_files.push_back(path);
+    return path;
+  }
+
+  /**
+   * Returns the first line of a file.
+   */
+  std::string ReadFile(std::string const &a_name) const
+  {
+    std::ifstream file(m_path + "/" + a_name);
+    std::string line;
+    std::getline(file, line);
+    return line;
+  }
+
+ private:
+  std::string m_path;
+  std::vector<std::string> m_files;
+  std::vector<std::string> m_directories;
+};
+
+}
+}
+}
+
+#endif
@@ -19,6 +19,7 @@
 #ifndef LOGIC_MINIATURE_NAVIGATION_H
 #define LOGIC_MINIATURE_NAVIGATION_H
 
+#include <fstream>
 #include <map>
 #include <memory>
 
@@ -28,6 +29,8 @@
 #include <opendlv/data/environment/Line.h>
 #include <opendlv/data/environment/Point3.h>
 
+#include "TickCounters.h"
+
 namespace opendlv {
 namespace logic {
 namespace miniature {
@@ -46,6 +49,8 @@ class Navigation :
   void tearDown();
   virtual odcore::data::dmcp::ModuleExitCodeMessage::ModuleExitCode body();
   std::vector<data::environment::Point3> ReadPointString(std::string const &) const;
+  void Send(odcore::data::Container &);
+  void ReportTickCounters();
 
   odcore::base::Mutex m_mutex;
   std::vector<data::environment::Line> m_outerWalls;
@@ -55,6 +60,12 @@ class Navigation :
   std::map<uint16_t, bool> m_gpioReadings;
   std::vector<uint16_t> m_gpioOutputPins;
   std::vector<uint16_t> m_pwmOutputPins;
+  std::unique_ptr<common::miniature::TickCounters> m_tickCounters;
+  uint32_t m_messagesIn;
+  uint32_t m_statisticsTicks;
+  std::ofstream m_statisticsFile;
+
+  static uint32_t const TICK_HISTOGRAM_BINS = 40;
 };
 
 }
@@ -17,12 +17,16 @@
  */
 
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
 
 #include <opendavinci/odcore/base/KeyValueConfiguration.h>
 #include <opendavinci/odcore/base/Lock.h>
 #include <opendavinci/odcore/data/Container.h>
+#include <opendavinci/odcore/data/TimeStamp.h>
 #include <opendavinci/odcore/strings/StringToolbox.h>
 
 #include <opendavinci/odcore/wrapper/Eigen.h>
@@ -36,6 +40,8 @@ namespace opendlv {
 namespace logic {
 namespace miniature {
 
+uint32_t const Navigation::TICK_HISTOGRAM_BINS;
+
 /*
   Constructor.
 */
@@ -49,6 +55,10 @@ Navigation::Navigation(const int &argc, char **argv)
     , m_gpioReadings()
     , m_gpioOutputPins()
     , m_pwmOutputPins()
+    , m_tickCounters()
+    , m_messagesIn(0)
+    , m_statisticsTicks(0)
+    , m_statisticsFile()
 {
 }
 
@@ -118,6 +128,31 @@ void Navigation::setUp()
   for (uint32_t i = 0; i < m_pointsOfInterest.size(); i++) {
     std::cout << "Point of interest " << i << ": " << m_pointsOfInterest[i].toString() << std::endl;
   }
+
+  // The timing of the ticks is sent as TickStatistics this often, in s, 
+  // and can also be written as CSV. Zero sends nothing.
+  bool valueFound;
+  double statisticsInterval = kv.getOptionalValue<double>(
+      "logic-miniature-navigation.statistics-interval", valueFound);
+  if (!valueFound) {
+    statisticsInterval = 1.0;
+  }
+  double const period = 1.0 / static_cast<double>(getFrequency());
+  m_statisticsTicks = static_cast<uint32_t>(
+      std::max(std::round(statisticsInterval / period), 0.0));
+  m_tickCounters.reset(new common::miniature::TickCounters(period,
+      TICK_HISTOGRAM_BINS));
+  std::string const statisticsFile = kv.getOptionalValue<std::string>(
+      "logic-miniature-navigation.statistics-file", valueFound);
+  if (valueFound && m_statisticsTicks > 0) {
+    m_statisticsFile.open(statisticsFile.c_str());
+    if (m_statisticsFile.is_open()) {
+      common::miniature::TickCounters::WriteCsvHeader(m_statisticsFile);
+    } else {
+      std::cerr << "[" << getName() << "] Could not open " 
+          << statisticsFile << "." << std::endl;
+    }
+  }
 }
 
 /*
@@ -137,6 +172,7 @@ odcore::data::dmcp::ModuleExitCodeMessage::ModuleExitCode Navigation::body()
 {
   while (getModuleStateAndWaitForRemainingTimeInTimeslice() == 
       odcore::data::dmcp::ModuleStateMessage::RUNNING) {
+    m_tickCounters->BeginTick();
 
     // The mutex is required since 'body' and 'nextContainer' competes by
     // reading and writing to the class global maps, see also 'nextContainer'.
@@ -166,32 +202,48 @@ odcore::data::dmcp::ModuleExitCodeMessage::ModuleExitCode Navigation::body()
       opendlv::proxy::ToggleRequest request(pin, state);
       
       odcore::data::Container c(request);
-      getConference().send(c);
+      Send(c);
       
       std::cout << "[" << getName() << "] Sending ToggleRequest: " 
           << request.toString() << std::endl;
     }
 
     // Loop through all Pulse Width Modulation (PWM) pins and randomize their 
-    // value. The value is then sent as a message to the module interfacing
-    // to the actual hardware.
-    for (auto pin : m_pwmOutputPins) {
-      int32_t rand = (std::rand() % 11) - 5 ;
-      uint32_t value = 1500000 + rand * 100000;
-      
-      opendlv::proxy::PwmRequest request(pin, value);
-      
-      odcore::data::Container c(request);
-      getConference().send(c);
-      
-      std::cout << "[" << getName() << "] Sending PwmRequest: " 
-          << request.toString() << std::endl;
+    // value. The values are then sent together as one message to the module
+    // interfacing to the actual hardware, which applies them at the same time.
+    if (!m_pwmOutputPins.empty()) {
+      std::vector<uint16_t> pwmPins;
+      std::vector<uint32_t> pwmValues;
+      for (auto pin : m_pwmOutputPins) {
+        int32_t rand = (std::rand() % 11) - 5 ;
+        uint32_t value = 1500000 + rand * 100000;
+        pwmPins.push_back(pin);
+        pwmValues.push_back(value);
+      }
+
+      opendlv::proxy::PwmRequests pwmRequests;
+      pwmRequests.setListOfPins(pwmPins);
+      pwmRequests.setListOfDutyCyclesNs(pwmValues);
+
+      odcore::data::Container pwmContainer(pwmRequests);
+      Send(pwmContainer);
+
+      std::cout << "[" << getName() << "] Sending PwmRequests: " 
+          << pwmRequests.toString() << std::endl;
     }
 
     ///// Example above.
 
     ///// TODO: Add proper behaviours.
     std::cout << "TODO: Add proper behaviour." << std::endl;
+
+    m_tickCounters->EndTick();
+    m_tickCounters->AddMessagesIn(m_messagesIn);
+    m_messagesIn = 0;
+    if (m_statisticsTicks > 0 
+        && m_tickCounters->GetTicks() >= m_statisticsTicks) {
+      ReportTickCounters();
+    }
   }
   return odcore::data::dmcp::ModuleExitCodeMessage::OKAY;
 }
@@ -205,6 +257,8 @@ void Navigation::nextContainer(odcore::data::Container &a_c)
 {
   odcore::base::Lock l(m_mutex);
 
+  m_messagesIn++;
+
   int32_t dataType = a_c.getDataType();
   if (dataType == opendlv::proxy::AnalogReading::ID()) {
     opendlv::proxy::AnalogReading reading = 
@@ -218,6 +272,19 @@ void Navigation::nextContainer(odcore::data::Container &a_c)
     std::cout << "[" << getName() << "] Received an AnalogReading: " 
         << reading.toString() << "." << std::endl;
 
+  } else if (dataType == opendlv::proxy::AnalogReadings::ID()) {
+    opendlv::proxy::AnalogReadings readings = 
+        a_c.getData<opendlv::proxy::AnalogReadings>();
+
+    std::vector<uint16_t> pins = readings.getListOfPins();
+    std::vector<float> voltages = readings.getListOfVoltages();
+    for (uint32_t i = 0; i < pins.size() && i < voltages.size(); i++) {
+      m_analogReadings[pins[i]] = voltages[i];
+    }
+
+    std::cout << "[" << getName() << "] Received an AnalogReadings: " 
+        << readings.toString() << "." << std::endl;
+
   } else if (dataType == opendlv::proxy::ToggleReading::ID()) {
     opendlv::proxy::ToggleReading reading = 
         a_c.getData<opendlv::proxy::ToggleReading>();
@@ -255,6 +322,45 @@ std::vector<data::environment::Point3> Navigation::ReadPointString(std::string c
   return points;
 }
 
+void Navigation::Send(odcore::data::Container &a_container)
+{
+  getConference().send(a_container);
+  m_tickCounters->AddMessagesOut(1);
+}
+
+/*
+  Sends the timing of the ticks since the last report, writes it to the CSV
+  file if any, and starts counting again.
+*/
+void Navigation::ReportTickCounters()
+{
+  opendlv::system::TickStatistics statistics(m_tickCounters->GetTicks(), 
+      m_tickCounters->GetOverruns(), m_tickCounters->GetMessagesIn(), 
+      m_tickCounters->GetMessagesOut(), 
+      static_cast<float>(m_tickCounters->GetMeanComputeTime()), 
+      static_cast<float>(m_tickCounters->GetMaxComputeTime()), 
+      static_cast<float>(m_tickCounters->GetMeanWaitTime()), 
+      static_cast<float>(m_tickCounters->GetBinWidth()), 
+      m_tickCounters->GetComputeTimes(), m_tickCounters->GetWaitTimes());
+  odcore::data::Container c(statistics);
+  getConference().send(c);
+
+  if (m_statisticsFile.is_open()) {
+    // Rows are stamped with the time of day, as the planner has no 
+    // simulated time of its own.
+    odcore::data::TimeStamp const now;
+    m_tickCounters->WriteCsv(m_statisticsFile, 
+        static_cast<double>(now.toMicroseconds()) / 1000000.0);
+  }
+  if (m_tickCounters->GetOverruns() > 0) {
+    std::cerr << "[" << getName() << "] " << m_tickCounters->GetOverruns() 
+        << " of " << m_tickCounters->GetTicks() 
+        << " ticks took longer than the period, the longest " 
+        << m_tickCounters->GetMaxComputeTime() << " s." << std::endl;
+  }
+  m_tickCounters->Reset();
+}
+
 }
 }
 }
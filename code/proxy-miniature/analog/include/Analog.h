@@ -24,6 +24,12 @@
 #include <utility>
 
 #include <opendavinci/odcore/base/module/TimeTriggeredConferenceClientModule.h>
+#include <opendavinci/odcore/data/TimeStamp.h>
+
+#include "AnalogFilter.h"
+#include "AnalogInputs.h"
+#include "DistanceCalibration.h"
+#include "IioBuffer.h"
 
 namespace opendlv {
 namespace proxy {
@@ -41,11 +47,21 @@ class Analog : public odcore::base::module::TimeTriggeredConferenceClientModule
     virtual void tearDown();
     virtual odcore::data::dmcp::ModuleExitCodeMessage::ModuleExitCode body();
    
-    std::vector<std::pair<uint16_t, float>> getReadings();
+    void readPins();
+    bool readBuffer(odcore::data::TimeStamp &);
+    void sendReadings(odcore::data::TimeStamp const &);
+    std::vector<float> getFloats(std::string const &) const;
    
     float m_conversionConst;
     bool m_debug;
     std::vector<uint16_t> m_pins;
+    AnalogInputs m_inputs;
+    IioBuffer m_iioBuffer;
+    uint32_t m_oversampling;
+    std::vector<AnalogFilter> m_filters;
+    std::vector<DistanceCalibration> m_calibrations;
+    std::vector<float> m_voltages;
+    std::vector<float> m_distances;
 };
 
 } 
@@ -0,0 +1,66 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PROXY_MINIATURE_ANALOGFILTER_H
+#define PROXY_MINIATURE_ANALOGFILTER_H
+
+#include <array>
+#include <cstdint>
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+/**
+ * Filter for one analog channel. Raw samples are averaged in groups of the
+ * oversampling factor, passed through a sliding median and then through a
+ * first-order low-pass filter. The output is read once per publish, which
+ * decimates the sample rate to the publish rate.
+ */
+class AnalogFilter {
+ public:
+  static uint32_t const MAX_MEDIAN_SIZE = 15;
+
+  AnalogFilter(uint32_t const, uint32_t const, float const);
+  virtual ~AnalogFilter();
+
+  void Add(uint16_t const);
+  bool HasOutput() const;
+  float GetOutput() const;
+  void Reset();
+
+ private:
+  float Median() const;
+
+  uint32_t m_oversampling;
+  uint32_t m_medianSize;
+  float m_lowPassAlpha;
+  uint32_t m_sum;
+  uint32_t m_sumCount;
+  std::array<float, MAX_MEDIAN_SIZE> m_window;
+  uint32_t m_windowIndex;
+  uint32_t m_windowCount;
+  float m_output;
+  bool m_hasOutput;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,54 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PROXY_MINIATURE_ANALOGINPUTS_H
+#define PROXY_MINIATURE_ANALOGINPUTS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+/**
+ * Keeps the raw value files of a set of analog inputs open. A read is a
+ * single pread at offset zero, which makes sysfs convert again, parsed
+ * from a stack buffer.
+ */
+class AnalogInputs {
+ public:
+  AnalogInputs();
+  AnalogInputs(AnalogInputs const &) = delete;
+  AnalogInputs &operator=(AnalogInputs const &) = delete;
+  virtual ~AnalogInputs();
+
+  bool Open(std::string const &);
+  void Close();
+  bool Read(uint32_t const, uint16_t &) const;
+
+ private:
+  std::vector<int32_t> m_fds;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,56 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PROXY_MINIATURE_DISTANCECALIBRATION_H
+#define PROXY_MINIATURE_DISTANCECALIBRATION_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+/**
+ * Voltage to distance curve of an IR sensor. The calibration points are
+ * resampled into a dense table over the calibrated voltage range, so a
+ * lookup is one interpolation between two neighbouring table entries.
+ * Voltages outside the range are clamped to it.
+ */
+class DistanceCalibration {
+ public:
+  static uint32_t const TABLE_SIZE = 256;
+
+  DistanceCalibration();
+  virtual ~DistanceCalibration();
+
+  bool Build(std::vector<float> const &, std::vector<float> const &);
+  float GetDistance(float const) const;
+
+ private:
+  float m_minVoltage;
+  float m_indexPerVolt;
+  std::array<float, TABLE_SIZE> m_table;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,85 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PROXY_MINIATURE_IIOBUFFER_H
+#define PROXY_MINIATURE_IIOBUFFER_H
+
+#include <string>
+#include <vector>
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+/**
+ * Triggered, buffered capture from an IIO ADC. The scan elements of the
+ * given pins and the timestamp are enabled, and complete scans are read in
+ * bulk from the character device of the IIO device.
+ */
+class IioBuffer {
+ public:
+  IioBuffer(std::string const &, std::string const &);
+  IioBuffer(IioBuffer const &) = delete;
+  IioBuffer &operator=(IioBuffer const &) = delete;
+  virtual ~IioBuffer();
+
+  bool SetUpHrtimerTrigger(std::string const &, std::string const &,
+      float const);
+  bool Open(std::vector<uint16_t> const &, std::string const &,
+      uint32_t const);
+  void Close();
+  bool IsOpen() const;
+  uint32_t Read();
+  uint16_t GetRaw(uint32_t const, uint32_t const) const;
+  int64_t GetTimestampNs(uint32_t const) const;
+
+ private:
+  /**
+   * Layout of one scan element, as given by its type and index files.
+   */
+  struct ScanElement {
+    ScanElement();
+    bool isBigEndian;
+    uint32_t bits;
+    uint32_t storageBytes;
+    uint32_t shift;
+    uint32_t index;
+    uint32_t offset;
+  };
+
+  bool EnableScanElement(std::string const &, ScanElement &);
+  bool WriteAttribute(std::string const &, std::string const &) const;
+  std::string ReadAttribute(std::string const &) const;
+  uint64_t Extract(uint8_t const *, ScanElement const &) const;
+
+  std::string m_devicePath;
+  std::string m_bufferPath;
+  int32_t m_fd;
+  std::vector<ScanElement> m_channels;
+  ScanElement m_timestamp;
+  uint32_t m_scanBytes;
+  std::vector<uint8_t> m_data;
+  std::vector<uint16_t> m_raws;
+  std::vector<int64_t> m_timestampsNs;
+};
+
+}
+}
+}
+
+#endif
@@ -18,12 +18,12 @@
 
 #include <cmath>
 #include <iostream>
-#include <fstream>
 #include <string>
 #include <vector>
 
 #include <opendavinci/odcore/base/KeyValueConfiguration.h>
 #include <opendavinci/odcore/data/Container.h>
+#include <opendavinci/odcore/data/TimeStamp.h>
 
 #include <odvdminiature/GeneratedHeaders_ODVDMiniature.h>
 #include <opendavinci/odcore/strings/StringToolbox.h>
@@ -39,6 +39,13 @@ Analog::Analog(const int &argc, char **argv)
     , m_conversionConst()
     , m_debug()
     , m_pins()
+    , m_inputs()
+    , m_iioBuffer("/sys/bus/iio/devices/iio:device0", "/dev/iio:device0")
+    , m_oversampling(1)
+    , m_filters()
+    , m_calibrations()
+    , m_voltages()
+    , m_distances()
 {
 }
 
@@ -60,10 +67,104 @@ void Analog::setUp()
   for(std::string const& str : pinsVecString) {
     m_pins.push_back(std::stoi(str));
   }
+  m_voltages.assign(m_pins.size(), std::nanf(""));
+  m_distances.assign(m_pins.size(), std::nanf(""));
+
+  // Each pin gets its own filter. Without settings the samples pass through
+  // unfiltered.
+  bool valueFound;
+  m_oversampling = kv.getOptionalValue<uint32_t>(
+      "proxy-miniature-analog.oversampling", valueFound);
+  if (!valueFound || m_oversampling == 0) {
+    m_oversampling = 1;
+  }
+  uint32_t medianSize = kv.getOptionalValue<uint32_t>(
+      "proxy-miniature-analog.medianSize", valueFound);
+  if (!valueFound) {
+    medianSize = 1;
+  }
+  float lowPassAlpha = kv.getOptionalValue<float>(
+      "proxy-miniature-analog.lowPassAlpha", valueFound);
+  if (!valueFound) {
+    lowPassAlpha = 1.0f;
+  }
+  for (uint32_t i = 0; i < m_pins.size(); i++) {
+    m_filters.push_back(AnalogFilter(m_oversampling, medianSize, 
+          lowPassAlpha));
+  }
+
+  // Each pin gets a voltage to distance table, built from its own 
+  // calibration points if given, otherwise from the shared ones. Without 
+  // any points the linear model of the simulation is used.
+  std::vector<float> voltages = {0.0f, 1.8f};
+  std::vector<float> distances = {0.0f, 4.0f};
+  std::string const voltagesString = kv.getOptionalValue<std::string>(
+      "proxy-miniature-analog.calibrationVoltages", valueFound);
+  if (valueFound) {
+    voltages = getFloats(voltagesString);
+    distances = getFloats(kv.getValue<std::string>(
+          "proxy-miniature-analog.calibrationDistances"));
+  }
+  for (uint16_t const pin : m_pins) {
+    std::string const pinVoltagesString = kv.getOptionalValue<std::string>(
+        "proxy-miniature-analog.calibrationVoltages." + std::to_string(pin), 
+        valueFound);
+    DistanceCalibration calibration;
+    bool isBuilt;
+    if (valueFound) {
+      std::string const pinDistancesString = kv.getValue<std::string>(
+          "proxy-miniature-analog.calibrationDistances." 
+          + std::to_string(pin));
+      isBuilt = calibration.Build(getFloats(pinVoltagesString), 
+          getFloats(pinDistancesString));
+    } else {
+      isBuilt = calibration.Build(voltages, distances);
+    }
+    if (!isBuilt) {
+      std::cerr << "[" << getName() << "] Invalid calibration for pin " << pin 
+          << ", distances will be NaN." << std::endl;
+    }
+    m_calibrations.push_back(calibration);
+  }
+
+  for (uint16_t const pin : m_pins) {
+    std::string const filename = "/sys/bus/iio/devices/iio:device0/in_voltage" 
+        + std::to_string(pin) + "_raw";
+    if (!m_inputs.Open(filename)) {
+      std::cerr << "[" << getName() << "] Could not open " << filename 
+          << "." << std::endl;
+    }
+  }
+
+  // In buffered mode all pins are sampled together by an IIO trigger, and
+  // the scans are read in bulk with their timestamps.
+  std::string const mode = kv.getOptionalValue<std::string>(
+      "proxy-miniature-analog.mode", valueFound);
+  if (valueFound && mode == "buffered") {
+    std::string const trigger = kv.getValue<std::string>(
+        "proxy-miniature-analog.trigger");
+    float const samplingFrequency = kv.getValue<float>(
+        "proxy-miniature-analog.samplingFrequency");
+    uint32_t const bufferLength = kv.getValue<uint32_t>(
+        "proxy-miniature-analog.bufferLength");
+    std::string const configfsPath = "/sys/kernel/config/iio/triggers/hrtimer";
+    if (!m_iioBuffer.SetUpHrtimerTrigger(configfsPath, trigger, 
+          samplingFrequency)) {
+      std::cerr << "[" << getName() << "] Could not set up the trigger " 
+          << trigger << "." << std::endl;
+    }
+    if (!m_iioBuffer.Open(m_pins, trigger, bufferLength)) {
+      std::cerr << "[" << getName() 
+          << "] Could not start buffered capture, reading pins directly." 
+          << std::endl;
+    }
+  }
 }
 
 void Analog::tearDown() 
 {
+  m_iioBuffer.Close();
+  m_inputs.Close();
 }
 
 
@@ -71,43 +172,105 @@ odcore::data::dmcp::ModuleExitCodeMessage::ModuleExitCode Analog::body()
 {
   while (getModuleStateAndWaitForRemainingTimeInTimeslice() == 
         odcore::data::dmcp::ModuleStateMessage::RUNNING) {
-    std::vector<std::pair<uint16_t, float>> reading = getReadings();
-    for (std::pair<uint16_t, float> const& pair : reading) {
-      opendlv::proxy::AnalogReading message(pair.first, pair.second);
-      odcore::data::Container c(message);
-      getConference().send(c);
-    }
-    if(m_debug) {
-      std::cout << "[" << getName() << "] ";
-      for (std::pair<uint16_t, float> const& pair : reading) {
-        std::cout << "Pin " << pair.first << ": " << pair.second << " ";
+    odcore::data::TimeStamp sampleTimeStamp;
+    if (m_iioBuffer.IsOpen()) {
+      if (!readBuffer(sampleTimeStamp)) {
+        continue;
       }
-      std::cout << std::endl;
+    } else {
+      readPins();
     }
+    sendReadings(sampleTimeStamp);
   }
   return odcore::data::dmcp::ModuleExitCodeMessage::OKAY;
 }
 
-std::vector<std::pair<uint16_t, float>> Analog::getReadings() {
-  std::vector<std::pair<uint16_t, float>> reading;
-  for(uint16_t const pin : m_pins) {
-    std::string filename = "/sys/bus/iio/devices/iio:device0/in_voltage" 
-        + std::to_string(pin) + "_raw";
-    std::ifstream file(filename, std::ifstream::in);
-    std::string line;
-    if(file.is_open()){
-      std::getline(file, line);
-      uint16_t rawReading = std::stoi(line);
-      reading.push_back(std::make_pair(pin, rawReading*m_conversionConst));
+/**
+ * Filters all scans read from the IIO buffer. The sample time stamp is set
+ * to the time of the latest scan. Returns false if there were no new scans.
+ */
+bool Analog::readBuffer(odcore::data::TimeStamp &a_sampleTimeStamp)
+{
+  uint32_t const scanCount = m_iioBuffer.Read();
+  if (scanCount == 0) {
+    return false;
+  }
+  uint32_t const pinCount = static_cast<uint32_t>(m_pins.size());
+  for (uint32_t scan = 0; scan < scanCount; scan++) {
+    for (uint32_t i = 0; i < pinCount; i++) {
+      m_filters[i].Add(m_iioBuffer.GetRaw(scan, i));
+    }
+  }
+  for (uint32_t i = 0; i < pinCount; i++) {
+    m_voltages[i] = m_filters[i].GetOutput() * m_conversionConst;
+    m_distances[i] = m_calibrations[i].GetDistance(m_voltages[i]);
+  }
+
+  int64_t const timestampUs = m_iioBuffer.GetTimestampNs(scanCount - 1) / 1000;
+  a_sampleTimeStamp = odcore::data::TimeStamp(
+      static_cast<int32_t>(timestampUs / 1000000), 
+      static_cast<int32_t>(timestampUs % 1000000));
+  return true;
+}
+
+/**
+ * Reads and filters each pin directly. Each read triggers a new conversion,
+ * so oversampling reads the pins several times per tick.
+ */
+void Analog::readPins()
+{
+  for (uint32_t i = 0; i < m_pins.size(); i++) {
+    bool isRead = true;
+    for (uint32_t n = 0; n < m_oversampling && isRead; n++) {
+      uint16_t raw;
+      isRead = m_inputs.Read(i, raw);
+      if (isRead) {
+        m_filters[i].Add(raw);
+      }
+    }
+    if (isRead) {
+      m_voltages[i] = m_filters[i].GetOutput() * m_conversionConst;
     } else {
       std::cerr << "[" << getName() 
-          << "] Could not read from analog input. (pin: " << pin 
-          << ", filename: " << filename << ")" << std::endl;
-      reading.push_back(std::make_pair(pin,std::nanf("")));
+          << "] Could not read from analog input. (pin: " << m_pins[i] 
+          << ")" << std::endl;
+      m_voltages[i] = std::nanf("");
     }
-    file.close();
+    m_distances[i] = m_calibrations[i].GetDistance(m_voltages[i]);
+  }
+}
+
+/**
+ * Sends the readings of all pins in one message.
+ */
+void Analog::sendReadings(odcore::data::TimeStamp const &a_sampleTimeStamp)
+{
+  opendlv::proxy::AnalogReadings readings;
+  readings.setListOfPins(m_pins);
+  readings.setListOfVoltages(m_voltages);
+  readings.setListOfDistances(m_distances);
+  odcore::data::Container c(readings);
+  c.setSampleTimeStamp(a_sampleTimeStamp);
+  getConference().send(c);
+
+  if (m_debug) {
+    std::cout << "[" << getName() << "] ";
+    for (uint32_t i = 0; i < m_pins.size(); i++) {
+      std::cout << "Pin " << m_pins[i] << ": " << m_voltages[i] << " V, " 
+          << m_distances[i] << " m ";
+    }
+    std::cout << std::endl;
+  }
+}
+
+std::vector<float> Analog::getFloats(std::string const &a_string) const
+{
+  std::vector<float> values;
+  for (std::string const &str : 
+      odcore::strings::StringToolbox::split(a_string, ',')) {
+    values.push_back(std::stof(str));
   }
-  return reading;
+  return values;
 }
 
 }
@@ -0,0 +1,112 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "AnalogFilter.h"
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+uint32_t const AnalogFilter::MAX_MEDIAN_SIZE;
+
+AnalogFilter::AnalogFilter(uint32_t const a_oversampling,
+    uint32_t const a_medianSize, float const a_lowPassAlpha)
+    : m_oversampling(std::max(a_oversampling, 1u))
+    , m_medianSize(std::min(std::max(a_medianSize, 1u), MAX_MEDIAN_SIZE))
+    , m_lowPassAlpha(std::min(std::max(a_lowPassAlpha, 0.0f), 1.0f))
+    , m_sum(0)
+    , m_sumCount(0)
+    , m_window()
+    , m_windowIndex(0)
+    , m_windowCount(0)
+    , m_output(0.0f)
+    , m_hasOutput(false)
+{
+}
+
+AnalogFilter::~AnalogFilter()
+{
+}
+
+void AnalogFilter::Add(uint16_t const a_raw)
+{
+  m_sum += a_raw;
+  if (++m_sumCount < m_oversampling) {
+    return;
+  }
+  float const sample = static_cast<float>(m_sum) / m_oversampling;
+  m_sum = 0;
+  m_sumCount = 0;
+
+  m_window[m_windowIndex] = sample;
+  m_windowIndex = (m_windowIndex + 1) % m_medianSize;
+  m_windowCount = std::min(m_windowCount + 1, m_medianSize);
+
+  // The first sample sets the low-pass state directly.
+  float const median = Median();
+  float const alpha = m_hasOutput ? m_lowPassAlpha : 1.0f;
+  m_output += alpha * (median - m_output);
+  m_hasOutput = true;
+}
+
+bool AnalogFilter::HasOutput() const
+{
+  return m_hasOutput;
+}
+
+/**
+ * Returns the filtered value in raw units, or NaN before the first
+ * oversampled sample is complete.
+ */
+float AnalogFilter::GetOutput() const
+{
+  return m_hasOutput ? m_output : std::nanf("");
+}
+
+void AnalogFilter::Reset()
+{
+  m_sum = 0;
+  m_sumCount = 0;
+  m_windowIndex = 0;
+  m_windowCount = 0;
+  m_output = 0.0f;
+  m_hasOutput = false;
+}
+
+float AnalogFilter::Median() const
+{
+  // Insertion sort of a copy, which is cheap for the short windows used.
+  std::array<float, MAX_MEDIAN_SIZE> sorted;
+  for (uint32_t i = 0; i < m_windowCount; i++) {
+    float const value = m_window[i];
+    uint32_t j = i;
+    for (; j > 0 && sorted[j - 1] > value; j--) {
+      sorted[j] = sorted[j - 1];
+    }
+    sorted[j] = value;
+  }
+  return sorted[(m_windowCount - 1) / 2];
+}
+
+}
+}
+}
@@ -0,0 +1,88 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "AnalogInputs.h"
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+AnalogInputs::AnalogInputs()
+    : m_fds()
+{
+}
+
+AnalogInputs::~AnalogInputs()
+{
+  Close();
+}
+
+/**
+ * Opens the raw value file of the next input. An input that could not be
+ * opened keeps its index, but fails every read.
+ */
+bool AnalogInputs::Open(std::string const &a_filename)
+{
+  int32_t fd = open(a_filename.c_str(), O_RDONLY);
+  m_fds.push_back(fd);
+  return (fd >= 0);
+}
+
+void AnalogInputs::Close()
+{
+  for (int32_t fd : m_fds) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+  m_fds.clear();
+}
+
+bool AnalogInputs::Read(uint32_t const a_index, uint16_t &a_raw) const
+{
+  if (a_index >= m_fds.size() || m_fds[a_index] < 0) {
+    return false;
+  }
+
+  char buffer[8];
+  ssize_t length = pread(m_fds[a_index], buffer, sizeof(buffer), 0);
+  if (length <= 0) {
+    return false;
+  }
+
+  uint32_t value = 0;
+  ssize_t i = 0;
+  for (; i < length && buffer[i] >= '0' && buffer[i] <= '9'; i++) {
+    value = value * 10 + static_cast<uint32_t>(buffer[i] - '0');
+  }
+  if (i == 0 || value > UINT16_MAX) {
+    return false;
+  }
+  a_raw = static_cast<uint16_t>(value);
+  return true;
+}
+
+}
+}
+}
@@ -0,0 +1,103 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "DistanceCalibration.h"
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+uint32_t const DistanceCalibration::TABLE_SIZE;
+
+DistanceCalibration::DistanceCalibration()
+    : m_minVoltage(0.0f)
+    , m_indexPerVolt(0.0f)
+    , m_table()
+{
+  m_table.fill(std::nanf(""));
+}
+
+DistanceCalibration::~DistanceCalibration()
+{
+}
+
+/**
+ * Builds the table from calibration points given as voltages and the
+ * distances measured at them. At least two distinct voltages are needed.
+ */
+bool DistanceCalibration::Build(std::vector<float> const &a_voltages,
+    std::vector<float> const &a_distances)
+{
+  if (a_voltages.size() != a_distances.size() || a_voltages.size() < 2) {
+    return false;
+  }
+
+  std::vector<std::pair<float, float>> points;
+  for (uint32_t i = 0; i < a_voltages.size(); i++) {
+    points.push_back(std::make_pair(a_voltages[i], a_distances[i]));
+  }
+  std::sort(points.begin(), points.end());
+  float const minVoltage = points.front().first;
+  float const maxVoltage = points.back().first;
+  if (!(maxVoltage > minVoltage)) {
+    return false;
+  }
+
+  m_minVoltage = minVoltage;
+  m_indexPerVolt = (TABLE_SIZE - 1) / (maxVoltage - minVoltage);
+  uint32_t segment = 0;
+  for (uint32_t i = 0; i < TABLE_SIZE; i++) {
+    float const voltage = minVoltage + i / m_indexPerVolt;
+    while (segment + 2 < points.size() && voltage > points[segment + 1].first) {
+      segment++;
+    }
+    std::pair<float, float> const &a = points[segment];
+    std::pair<float, float> const &b = points[segment + 1];
+    float const width = b.first - a.first;
+    float const t = (width > 0.0f) ? (voltage - a.first) / width : 0.0f;
+    m_table[i] = a.second + std::min(std::max(t, 0.0f), 1.0f)
+        * (b.second - a.second);
+  }
+  return true;
+}
+
+/**
+ * Returns the distance for a voltage, or NaN for NaN or before the table is
+ * built.
+ */
+float DistanceCalibration::GetDistance(float const a_voltage) const
+{
+  float const index = std::min(std::max(
+        (a_voltage - m_minVoltage) * m_indexPerVolt, 0.0f),
+      static_cast<float>(TABLE_SIZE - 1));
+  if (std::isnan(index)) {
+    return std::nanf("");
+  }
+  uint32_t const i = std::min(static_cast<uint32_t>(index), TABLE_SIZE - 2);
+  float const t = index - i;
+  return m_table[i] + t * (m_table[i + 1] - m_table[i]);
+}
+
+}
+}
+}
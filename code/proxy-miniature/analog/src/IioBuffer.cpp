@@ -0,0 +1,303 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "IioBuffer.h"
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+IioBuffer::IioBuffer(std::string const &a_devicePath,
+    std::string const &a_bufferPath)
+    : m_devicePath(a_devicePath)
+    , m_bufferPath(a_bufferPath)
+    , m_fd(-1)
+    , m_channels()
+    , m_timestamp()
+    , m_scanBytes(0)
+    , m_data()
+    , m_raws()
+    , m_timestampsNs()
+{
+}
+
+IioBuffer::~IioBuffer()
+{
+  Close();
+}
+
+IioBuffer::ScanElement::ScanElement()
+    : isBigEndian(false)
+    , bits(0)
+    , storageBytes(0)
+    , shift(0)
+    , index(0)
+    , offset(0)
+{
+}
+
+/**
+ * Creates a hrtimer trigger through configfs, unless a trigger with the
+ * given name already exists, and sets its sampling frequency.
+ */
+bool IioBuffer::SetUpHrtimerTrigger(std::string const &a_configfsPath,
+    std::string const &a_name, float const a_samplingFrequency)
+{
+  std::string const triggerPath = a_configfsPath + "/" + a_name;
+  if (mkdir(triggerPath.c_str(), 0755) != 0 && errno != EEXIST) {
+    return false;
+  }
+
+  std::string const devicesPath =
+      m_devicePath.substr(0, m_devicePath.find_last_of('/'));
+  DIR *devices = opendir(devicesPath.c_str());
+  if (devices == nullptr) {
+    return false;
+  }
+  bool isFound = false;
+  struct dirent *entry;
+  while (!isFound && (entry = readdir(devices)) != nullptr) {
+    std::string const name(entry->d_name);
+    if (name.compare(0, 7, "trigger") != 0) {
+      continue;
+    }
+    std::string const path = devicesPath + "/" + name;
+    if (ReadAttribute(path + "/name") == a_name) {
+      isFound = WriteAttribute(path + "/sampling_frequency",
+          std::to_string(static_cast<int32_t>(a_samplingFrequency)));
+    }
+  }
+  closedir(devices);
+  return isFound;
+}
+
+/**
+ * Enables the scan elements of the given pins and the timestamp, attaches
+ * the trigger and starts a kernel buffer of the given number of scans.
+ */
+bool IioBuffer::Open(std::vector<uint16_t> const &a_pins,
+    std::string const &a_trigger, uint32_t const a_length)
+{
+  Close();
+
+  // The buffer must be disabled while it is being configured.
+  WriteAttribute(m_devicePath + "/buffer/enable", "0");
+
+  m_channels.clear();
+  for (uint16_t const pin : a_pins) {
+    ScanElement channel;
+    if (!EnableScanElement("in_voltage" + std::to_string(pin), channel)) {
+      return false;
+    }
+    m_channels.push_back(channel);
+  }
+  if (!EnableScanElement("in_timestamp", m_timestamp)) {
+    return false;
+  }
+
+  // Elements are packed in index order, each aligned to its own size, and
+  // the scan is padded to the size of its largest element.
+  std::vector<ScanElement *> elements;
+  for (ScanElement &channel : m_channels) {
+    elements.push_back(&channel);
+  }
+  elements.push_back(&m_timestamp);
+  std::sort(elements.begin(), elements.end(),
+      [](ScanElement const *a_a, ScanElement const *a_b) {
+        return a_a->index < a_b->index;
+      });
+  uint32_t offset = 0;
+  uint32_t alignment = 1;
+  for (ScanElement *element : elements) {
+    uint32_t const bytes = element->storageBytes;
+    offset = (offset + bytes - 1) / bytes * bytes;
+    element->offset = offset;
+    offset += bytes;
+    alignment = std::max(alignment, bytes);
+  }
+  m_scanBytes = (offset + alignment - 1) / alignment * alignment;
+
+  if (!a_trigger.empty() && !WriteAttribute(
+        m_devicePath + "/trigger/current_trigger", a_trigger)) {
+    return false;
+  }
+  if (!WriteAttribute(m_devicePath + "/buffer/length",
+        std::to_string(a_length))
+      || !WriteAttribute(m_devicePath + "/buffer/enable", "1")) {
+    return false;
+  }
+
+  m_fd = open(m_bufferPath.c_str(), O_RDONLY | O_NONBLOCK);
+  if (m_fd < 0) {
+    WriteAttribute(m_devicePath + "/buffer/enable", "0");
+    return false;
+  }
+
+  m_data.assign(m_scanBytes * a_length, 0);
+  m_raws.assign(m_channels.size() * a_length, 0);
+  m_timestampsNs.assign(a_length, 0);
+  return true;
+}
+
+void IioBuffer::Close()
+{
+  if (m_fd < 0) {
+    return;
+  }
+  close(m_fd);
+  m_fd = -1;
+  WriteAttribute(m_devicePath + "/buffer/enable", "0");
+}
+
+bool IioBuffer::IsOpen() const
+{
+  return (m_fd >= 0);
+}
+
+/**
+ * Reads all complete scans available in the kernel buffer, up to its length,
+ * and unpacks them. Returns the number of scans read.
+ */
+uint32_t IioBuffer::Read()
+{
+  if (m_fd < 0) {
+    return 0;
+  }
+  ssize_t const length = read(m_fd, m_data.data(), m_data.size());
+  if (length <= 0) {
+    return 0;
+  }
+
+  uint32_t const scanCount = static_cast<uint32_t>(length) / m_scanBytes;
+  uint32_t const channelCount = static_cast<uint32_t>(m_channels.size());
+  for (uint32_t i = 0; i < scanCount; i++) {
+    uint8_t const *scan = m_data.data() + i * m_scanBytes;
+    for (uint32_t j = 0; j < channelCount; j++) {
+      m_raws[i * channelCount + j] =
+          static_cast<uint16_t>(Extract(scan, m_channels[j]));
+    }
+    m_timestampsNs[i] = static_cast<int64_t>(Extract(scan, m_timestamp));
+  }
+  return scanCount;
+}
+
+/**
+ * Returns the raw value of a channel, in the order the pins were given, for
+ * a scan from the last read.
+ */
+uint16_t IioBuffer::GetRaw(uint32_t const a_scan,
+    uint32_t const a_channel) const
+{
+  return m_raws[a_scan * m_channels.size() + a_channel];
+}
+
+int64_t IioBuffer::GetTimestampNs(uint32_t const a_scan) const
+{
+  return m_timestampsNs[a_scan];
+}
+
+/**
+ * Enables a scan element and parses its type, for example "le:u12/16>>0",
+ * and index.
+ */
+bool IioBuffer::EnableScanElement(std::string const &a_name,
+    ScanElement &a_element)
+{
+  std::string const path = m_devicePath + "/scan_elements/" + a_name;
+  if (!WriteAttribute(path + "_en", "1")) {
+    return false;
+  }
+
+  std::string const type = ReadAttribute(path + "_type");
+  char endianness[3] = {0};
+  char sign;
+  uint32_t bits;
+  uint32_t storageBits;
+  uint32_t shift;
+  if (sscanf(type.c_str(), "%2c:%c%u/%u>>%u", endianness, &sign, &bits,
+        &storageBits, &shift) != 5 || storageBits % 8 != 0
+      || storageBits == 0 || storageBits > 64) {
+    return false;
+  }
+  std::string const index = ReadAttribute(path + "_index");
+  if (index.empty()) {
+    return false;
+  }
+
+  a_element.isBigEndian = (endianness[0] == 'b');
+  a_element.bits = bits;
+  a_element.storageBytes = storageBits / 8;
+  a_element.shift = shift;
+  a_element.index = static_cast<uint32_t>(std::stoi(index));
+  return true;
+}
+
+bool IioBuffer::WriteAttribute(std::string const &a_filename,
+    std::string const &a_value) const
+{
+  std::ofstream file(a_filename, std::ofstream::out);
+  if (!file.is_open()) {
+    return false;
+  }
+  file << a_value;
+  file.flush();
+  return file.good();
+}
+
+std::string IioBuffer::ReadAttribute(std::string const &a_filename) const
+{
+  std::ifstream file(a_filename, std::ifstream::in);
+  std::string line;
+  if (file.is_open()) {
+    std::getline(file, line);
+  }
+  return line;
+}
+
+uint64_t IioBuffer::Extract(uint8_t const *a_scan,
+    ScanElement const &a_element) const
+{
+  uint8_t const *bytes = a_scan + a_element.offset;
+  uint64_t value = 0;
+  for (uint32_t i = 0; i < a_element.storageBytes; i++) {
+    uint32_t const byte = a_element.isBigEndian ? i
+        : a_element.storageBytes - 1 - i;
+    value = (value << 8) | bytes[byte];
+  }
+  value >>= a_element.shift;
+  if (a_element.bits < 64) {
+    value &= (static_cast<uint64_t>(1) << a_element.bits) - 1;
+  }
+  return value;
+}
+
+}
+}
+}
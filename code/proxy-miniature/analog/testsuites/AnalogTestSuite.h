@@ -20,10 +20,28 @@
 #ifndef ANALOG_TESTSUITE_H
 #define ANALOG_TESTSUITE_H
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "cxxtest/TestSuite.h"
 
 // Include local header files.
 #include "../include/Analog.h"
+#include "../include/AnalogFilter.h"
+#include "../include/AnalogInputs.h"
+#include "../include/DistanceCalibration.h"
+#include "../include/IioBuffer.h"
+#include "../../../common-miniature/testsuites/TemporaryDirectory.h"
+
+using namespace opendlv::proxy::miniature;
+using opendlv::common::miniature::TemporaryDirectory;
 
 class AnalogTest : public CxxTest::TestSuite {
    public:
@@ -34,6 +52,237 @@ class AnalogTest : public CxxTest::TestSuite {
     void testApplication() {
         TS_ASSERT(true);
     }
+
+    void testIioBufferUnpacksScans() {
+        TemporaryDirectory directory("analogtest");
+        std::string const &device = directory.GetPath();
+        directory.MakeDirectory("scan_elements");
+        directory.MakeDirectory("buffer");
+        directory.MakeDirectory("trigger");
+
+        // Two 12 bit channels stored in 16 bits, where pin 3 comes before
+        // pin 1 in the scan, followed by the 64 bit timestamp.
+        directory.WriteFile("scan_elements/in_voltage1_type", "le:u12/16>>0");
+        directory.WriteFile("scan_elements/in_voltage1_index", "1");
+        directory.WriteFile("scan_elements/in_voltage3_type", "le:u12/16>>0");
+        directory.WriteFile("scan_elements/in_voltage3_index", "0");
+        directory.WriteFile("scan_elements/in_timestamp_type", "le:s64/64>>0");
+        directory.WriteFile("scan_elements/in_timestamp_index", "8");
+
+        // Each scan is 2 + 2 bytes of samples, 4 bytes of padding and 8 
+        // bytes of timestamp.
+        std::vector<uint8_t> data;
+        for (uint32_t i = 0; i < 3; i++) {
+            uint16_t const pin3 = static_cast<uint16_t>(0xf000 | (100 + i));
+            uint16_t const pin1 = static_cast<uint16_t>(4000 + i);
+            int64_t const timestamp = static_cast<int64_t>(1000000000) 
+                + static_cast<int64_t>(i) * 1000000;
+            AppendLittleEndian(data, pin3, 2);
+            AppendLittleEndian(data, pin1, 2);
+            AppendLittleEndian(data, 0, 4);
+            AppendLittleEndian(data, static_cast<uint64_t>(timestamp), 8);
+        }
+        std::ofstream bufferFile(directory.AddFile("dev"));
+        bufferFile.write(reinterpret_cast<char const *>(data.data()), 
+            static_cast<std::streamsize>(data.size()));
+        bufferFile.close();
+
+        // The attributes written by the buffer.
+        directory.AddFile("scan_elements/in_voltage1_en");
+        directory.AddFile("scan_elements/in_voltage3_en");
+        directory.AddFile("scan_elements/in_timestamp_en");
+        directory.AddFile("trigger/current_trigger");
+        directory.AddFile("buffer/length");
+        directory.AddFile("buffer/enable");
+
+        IioBuffer buffer(device, device + "/dev");
+        std::vector<uint16_t> pins = {1, 3};
+        TS_ASSERT(buffer.Open(pins, "analog-trigger", 16));
+        TS_ASSERT(buffer.IsOpen());
+        TS_ASSERT_EQUALS(directory.ReadFile("scan_elements/in_voltage1_en"), 
+            "1");
+        TS_ASSERT_EQUALS(directory.ReadFile("scan_elements/in_timestamp_en"), 
+            "1");
+        TS_ASSERT_EQUALS(directory.ReadFile("trigger/current_trigger"), 
+            "analog-trigger");
+        TS_ASSERT_EQUALS(directory.ReadFile("buffer/length"), "16");
+        TS_ASSERT_EQUALS(directory.ReadFile("buffer/enable"), "1");
+
+        TS_ASSERT_EQUALS(buffer.Read(), 3u);
+        TS_ASSERT_EQUALS(buffer.GetRaw(0, 0), 4000);
+        TS_ASSERT_EQUALS(buffer.GetRaw(0, 1), 100);
+        TS_ASSERT_EQUALS(buffer.GetRaw(2, 0), 4002);
+        TS_ASSERT_EQUALS(buffer.GetRaw(2, 1), 102);
+        TS_ASSERT_EQUALS(buffer.GetTimestampNs(2), 
+            static_cast<int64_t>(1002000000));
+        TS_ASSERT_EQUALS(buffer.Read(), 0u);
+
+        buffer.Close();
+        TS_ASSERT(!buffer.IsOpen());
+        TS_ASSERT_EQUALS(directory.ReadFile("buffer/enable"), "0");
+
+    }
+
+    void testFilterPassesThroughByDefault() {
+        AnalogFilter filter(1, 1, 1.0f);
+        TS_ASSERT(!filter.HasOutput());
+        TS_ASSERT(std::isnan(filter.GetOutput()));
+        filter.Add(1000);
+        TS_ASSERT_DELTA(filter.GetOutput(), 1000.0f, 1e-3f);
+        filter.Add(1200);
+        TS_ASSERT_DELTA(filter.GetOutput(), 1200.0f, 1e-3f);
+    }
+
+    void testFilterOversamplesAndRejectsSpikes() {
+        AnalogFilter filter(4, 3, 1.0f);
+        filter.Add(1000);
+        filter.Add(1002);
+        filter.Add(1004);
+        TS_ASSERT(!filter.HasOutput());
+        filter.Add(1006);
+        TS_ASSERT_DELTA(filter.GetOutput(), 1003.0f, 1e-3f);
+
+        // A single oversampled spike does not pass the median.
+        for (uint32_t i = 0; i < 4; i++) {
+            filter.Add(4000);
+        }
+        TS_ASSERT_DELTA(filter.GetOutput(), 1003.0f, 1e-3f);
+        for (uint32_t i = 0; i < 4; i++) {
+            filter.Add(1011);
+        }
+        TS_ASSERT_DELTA(filter.GetOutput(), 1011.0f, 1e-3f);
+
+        filter.Reset();
+        TS_ASSERT(!filter.HasOutput());
+    }
+
+    void testFilterLowPass() {
+        AnalogFilter filter(1, 1, 0.25f);
+        filter.Add(0);
+        filter.Add(1000);
+        TS_ASSERT_DELTA(filter.GetOutput(), 250.0f, 1e-3f);
+        filter.Add(1000);
+        TS_ASSERT_DELTA(filter.GetOutput(), 437.5f, 1e-3f);
+    }
+
+    void testCalibrationInterpolatesAndClamps() {
+        DistanceCalibration calibration;
+        TS_ASSERT(std::isnan(calibration.GetDistance(1.0f)));
+        TS_ASSERT(!calibration.Build({0.4f}, {0.8f}));
+        TS_ASSERT(!calibration.Build({0.4f, 0.4f}, {0.8f, 0.1f}));
+
+        // Points may be given in any order.
+        std::vector<float> voltages = {1.6f, 0.4f, 0.8f};
+        std::vector<float> distances = {0.1f, 0.8f, 0.4f};
+        TS_ASSERT(calibration.Build(voltages, distances));
+        TS_ASSERT_DELTA(calibration.GetDistance(0.4f), 0.8f, 1e-4f);
+        TS_ASSERT_DELTA(calibration.GetDistance(0.6f), 0.6f, 1e-3f);
+        TS_ASSERT_DELTA(calibration.GetDistance(0.8f), 0.4f, 1e-3f);
+        TS_ASSERT_DELTA(calibration.GetDistance(1.2f), 0.25f, 1e-3f);
+        TS_ASSERT_DELTA(calibration.GetDistance(1.6f), 0.1f, 1e-4f);
+        TS_ASSERT_DELTA(calibration.GetDistance(0.0f), 0.8f, 1e-4f);
+        TS_ASSERT_DELTA(calibration.GetDistance(1.8f), 0.1f, 1e-4f);
+        TS_ASSERT(std::isnan(calibration.GetDistance(std::nanf(""))));
+    }
+
+    void testInputsParseRawValues() {
+        TemporaryDirectory directory("analogtest");
+        directory.WriteFile("in_voltage0_raw", "4095\n");
+        directory.WriteFile("in_voltage1_raw", "invalid\n");
+
+        AnalogInputs inputs;
+        TS_ASSERT(inputs.Open(directory.GetPath() + "/in_voltage0_raw"));
+        TS_ASSERT(inputs.Open(directory.GetPath() + "/in_voltage1_raw"));
+        TS_ASSERT(!inputs.Open(directory.GetPath() + "/in_voltage2_raw"));
+
+        uint16_t raw = 0;
+        TS_ASSERT(inputs.Read(0, raw));
+        TS_ASSERT_EQUALS(raw, 4095);
+        TS_ASSERT(!inputs.Read(1, raw));
+        TS_ASSERT(!inputs.Read(2, raw));
+        TS_ASSERT(!inputs.Read(3, raw));
+
+        // The file is read again from the start on every read.
+        directory.WriteFile("in_voltage0_raw", "17\n");
+        TS_ASSERT(inputs.Read(0, raw));
+        TS_ASSERT_EQUALS(raw, 17);
+
+        inputs.Close();
+    }
+
+    void testInputsTickCost() {
+        uint32_t const pinCount = 7;
+        uint32_t const ticks = 2000;
+        TemporaryDirectory directory("analogtest");
+        for (uint32_t pin = 0; pin < pinCount; pin++) {
+            directory.WriteFile("in_voltage" + std::to_string(pin) + "_raw",
+                std::to_string(1000 + pin) + "\n");
+        }
+
+        // Per tick cost of reading the pins the way the proxy used to, with a
+        // new file stream per pin and a fresh vector of readings.
+        std::vector<int64_t> beforeNs;
+        float sum = 0.0f;
+        for (uint32_t n = 0; n < ticks; n++) {
+            auto start = std::chrono::steady_clock::now();
+            std::vector<std::pair<uint16_t, float>> reading;
+            for (uint16_t pin = 0; pin < pinCount; pin++) {
+                std::string filename = directory.GetPath() + "/in_voltage" 
+                    + std::to_string(pin) + "_raw";
+                std::ifstream file(filename, std::ifstream::in);
+                std::string line;
+                std::getline(file, line);
+                uint16_t rawReading = std::stoi(line);
+                reading.push_back(std::make_pair(pin, rawReading * 1.0f));
+            }
+            auto end = std::chrono::steady_clock::now();
+            sum += reading.back().second;
+            beforeNs.push_back(std::chrono::duration_cast<
+                std::chrono::nanoseconds>(end - start).count());
+        }
+
+        // Per tick cost with the files kept open.
+        AnalogInputs inputs;
+        for (uint32_t pin = 0; pin < pinCount; pin++) {
+            inputs.Open(directory.GetPath() + "/in_voltage" 
+                + std::to_string(pin) + "_raw");
+        }
+        std::vector<float> voltages(pinCount, 0.0f);
+        std::vector<int64_t> afterNs;
+        for (uint32_t n = 0; n < ticks; n++) {
+            auto start = std::chrono::steady_clock::now();
+            for (uint32_t i = 0; i < pinCount; i++) {
+                uint16_t raw = 0;
+                inputs.Read(i, raw);
+                voltages[i] = raw * 1.0f;
+            }
+            auto end = std::chrono::steady_clock::now();
+            sum += voltages.back();
+            afterNs.push_back(std::chrono::duration_cast<
+                std::chrono::nanoseconds>(end - start).count());
+        }
+
+        std::sort(beforeNs.begin(), beforeNs.end());
+        std::sort(afterNs.begin(), afterNs.end());
+        int64_t const before = beforeNs[ticks / 2];
+        int64_t const after = afterNs[ticks / 2];
+        std::cout << std::endl << "Median cost of reading " << pinCount 
+            << " pins per tick, before: " << before << " ns, after: " 
+            << after << " ns." << std::endl;
+
+        TS_ASSERT(sum > 0.0f);
+        TS_ASSERT_LESS_THAN(after, before);
+
+        inputs.Close();
+    }
+
+   private:
+    void AppendLittleEndian(std::vector<uint8_t> &a_data, uint64_t a_value, 
+        uint32_t a_bytes) {
+        for (uint32_t i = 0; i < a_bytes; i++) {
+            a_data.push_back(static_cast<uint8_t>(a_value >> (8 * i)));
+        }
+    }
 };
 
 #endif
@@ -21,13 +21,17 @@
 #define PROXY_MINIATURE_GPIO_H
 
 
+#include <chrono>
 #include <memory>
 #include <string>
 #include <vector>
 #include <utility>
 
+#include <opendavinci/odcore/base/Mutex.h>
 #include <opendavinci/odcore/base/module/TimeTriggeredConferenceClientModule.h>
 
+#include "GpioPins.h"
+
 namespace opendlv {
 namespace proxy {
 namespace miniature {
@@ -51,16 +55,20 @@ class Gpio : public odcore::base::module::TimeTriggeredConferenceClientModule {
   void OpenGpio();
   void CloseGpio();
   void Reset();
+  void CheckWatchdog();
   void SetDirection(uint16_t const, std::string);
   std::string GetDirection(uint16_t const) const;
   void SetValue(uint16_t const, bool const);
   bool GetValue(uint16_t const) const;
 
+  odcore::base::Mutex m_mutex;
   bool m_debug;
   bool m_initialised;
   std::vector<std::pair<bool, std::string>> m_initialValuesDirections;
   std::string m_path;
   std::vector<uint16_t> m_pins;
+  GpioPins m_gpioPins;
+  std::chrono::milliseconds m_watchdogTimeout;
 };
 
 }
@@ -0,0 +1,79 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef PROXY_MINIATURE_GPIOPINS_H
+#define PROXY_MINIATURE_GPIOPINS_H
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+/**
+ * Keeps the value files of a set of exported pins open. A value equal to 
+ * the one last written to an output is not written again. Outputs fall 
+ * back to their safe values when no request has arrived for them within 
+ * the watchdog timeout.
+ */
+class GpioPins {
+ public:
+  GpioPins();
+  GpioPins(GpioPins const &) = delete;
+  GpioPins &operator=(GpioPins const &) = delete;
+  virtual ~GpioPins();
+
+  bool Open(uint16_t const, std::string const &, bool const);
+  void Close();
+  bool HasPin(uint16_t const) const;
+  bool IsOutput(uint16_t const) const;
+  bool SetSafeValue(uint16_t const, bool const);
+  bool Request(uint16_t const, bool const);
+  bool SetValue(uint16_t const, bool const);
+  bool GetValue(uint16_t const, bool &) const;
+  uint32_t CheckWatchdog(std::chrono::milliseconds const, 
+      std::chrono::steady_clock::time_point const &, std::vector<uint16_t> &);
+  void SetSafe();
+  uint32_t GetWrites() const;
+
+ private:
+  struct Pin {
+    Pin();
+    bool isOutput;
+    int32_t valueFd;
+    int8_t lastValue;
+    bool safeValue;
+    bool isSafe;
+    std::chrono::steady_clock::time_point requestTime;
+  };
+
+  bool Write(Pin &, bool const);
+
+  std::unordered_map<uint16_t, Pin> m_pins;
+  uint32_t m_writes;
+};
+
+}
+}
+}
+
+#endif
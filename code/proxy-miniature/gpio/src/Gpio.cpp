@@ -17,12 +17,14 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  */
 
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
 
 #include <opendavinci/odcore/base/KeyValueConfiguration.h>
+#include <opendavinci/odcore/base/Lock.h>
 #include <opendavinci/odcore/data/Container.h>
 #include <opendavinci/odcore/strings/StringToolbox.h>
 
@@ -36,11 +38,14 @@ namespace miniature {
 
 Gpio::Gpio(const int &argc, char **argv)
     : TimeTriggeredConferenceClientModule(argc, argv, "proxy-miniature-gpio")
+    , m_mutex()
     , m_debug()
     , m_initialised()
     , m_initialValuesDirections()
     , m_path()
     , m_pins()
+    , m_gpioPins()
+    , m_watchdogTimeout(0)
 {
 }
 
@@ -107,11 +112,51 @@ void Gpio::setUp()
 
   OpenGpio();
 
+  // Safe values are set at tearDown and, with the optional watchdog, when no
+  // request for an output has arrived within the timeout. The initial values
+  // are used unless others are given.
+  bool valueFound;
+  std::string const safeValuesString = kv.getOptionalValue<std::string>(
+      "proxy-miniature-gpio.safeValues", valueFound);
+  std::vector<std::string> safeValuesVector;
+  if (valueFound) {
+    safeValuesVector = 
+        odcore::strings::StringToolbox::split(safeValuesString, ',');
+    if (safeValuesVector.size() != m_pins.size()) {
+      cerr << "[" << getName() 
+          << "] Number of pins do not equals to number of safe values." 
+          << std::endl;
+      safeValuesVector.clear();
+    }
+  }
+  for (uint16_t i = 0; i < m_pins.size(); i++) {
+    bool safeValue = m_initialValuesDirections[i].first;
+    if (!safeValuesVector.empty()) {
+      safeValue = static_cast<bool>(std::stoi(safeValuesVector.at(i)));
+    }
+    if (!m_gpioPins.SetSafeValue(m_pins[i], safeValue)) {
+      cerr << "[" << getName() << "] Pin " << m_pins[i] 
+          << " is not exported and has no safe value." << std::endl;
+    }
+  }
+
+  uint32_t const watchdogTimeoutMs = kv.getOptionalValue<uint32_t>(
+      "proxy-miniature-gpio.watchdogTimeoutMs", valueFound);
+  if (valueFound) {
+    m_watchdogTimeout = std::chrono::milliseconds(watchdogTimeoutMs);
+  }
+
   m_initialised = true;
 }
 
+/**
+ * The lock is held until the pins are closed, so that no request can reach
+ * a pin after it has been set to its safe value.
+ */
 void Gpio::tearDown()
 {
+  odcore::base::Lock l(m_mutex);
+  m_gpioPins.SetSafe();
   CloseGpio();
 }
 
@@ -119,9 +164,21 @@ odcore::data::dmcp::ModuleExitCodeMessage::ModuleExitCode Gpio::body()
 {
   while (getModuleStateAndWaitForRemainingTimeInTimeslice() == 
       odcore::data::dmcp::ModuleStateMessage::RUNNING) {
-    for (auto pin : m_pins) {
+    CheckWatchdog();
+
+    // The values are read under the lock, as requests may write the pins at
+    // the same time, and sent after it is released.
+    std::vector<bool> values;
+    {
+      odcore::base::Lock l(m_mutex);
+      for (auto pin : m_pins) {
+        values.push_back(GetValue(pin));
+      }
+    }
+    for (uint16_t i = 0; i < m_pins.size(); i++) {
+      uint16_t pin = m_pins[i];
       // std::string direction = GetDirection(pin);
-      bool value = GetValue(pin);
+      bool value = values[i];
       opendlv::proxy::ToggleReading::ToggleState state;
       if (value) {
         state = opendlv::proxy::ToggleReading::On;
@@ -134,10 +191,10 @@ odcore::data::dmcp::ModuleExitCodeMessage::ModuleExitCode Gpio::body()
     }
     if (m_debug) {
       std::cout << "Number of pins: " << m_pins.size() << std::endl;
-      for (auto pin : m_pins) {
-        std::cout << "[" << getName() << "] Pin: " << pin 
-            << " Direction: " << GetDirection(pin) 
-            << " Value: " << GetValue(pin) 
+      for (uint16_t i = 0; i < m_pins.size(); i++) {
+        std::cout << "[" << getName() << "] Pin: " << m_pins[i] 
+            << " Direction: " << GetDirection(m_pins[i]) 
+            << " Value: " << values[i] 
             << "." << std::endl;
       }
     }
@@ -156,8 +213,16 @@ void Gpio::nextContainer(odcore::data::Container &a_container)
         a_container.getData<opendlv::proxy::ToggleRequest>();
     uint16_t pin = request.getPin();
     bool value = request.getState();
-    if (GetDirection(pin).compare("out") == 0) {
-      SetValue(pin, value);
+    odcore::base::Lock l(m_mutex);
+    if (!m_gpioPins.HasPin(pin)) {
+      cerr << "[" << getName() << "] The requested pin " << pin
+          << " is not exported." 
+          << std::endl;
+    } else if (m_gpioPins.IsOutput(pin)) {
+      if (!m_gpioPins.Request(pin, value)) {
+        cerr << "[" << getName() << "] Could not write value of pin " << pin 
+            << "." << std::endl;
+      }
     } else {
       cerr << "[" << getName() << "] The requested pin " << pin
           << " is read-only." 
@@ -176,6 +241,19 @@ void Gpio::OpenGpio()
       exportFile << pin;
       exportFile.flush();
     }
+    for (uint16_t i = 0; i < m_pins.size(); i++) {
+      uint16_t pin = m_pins[i];
+      std::string direction = m_initialValuesDirections[i].second;
+      SetDirection(pin, direction);
+
+      bool const isOutput = (direction.compare("out") == 0);
+      std::string gpioValueFilename = 
+          m_path + "/gpio" + std::to_string(pin) + "/value";
+      if (!m_gpioPins.Open(pin, gpioValueFilename, isOutput)) {
+        cerr << "[" << getName() << "] Could not open " << gpioValueFilename 
+            << "." << std::endl;
+      }
+    }
     Reset();
   } else {
     cerr << "[" << getName() << "] Could not open " << filename << "." 
@@ -186,6 +264,8 @@ void Gpio::OpenGpio()
 
 void Gpio::CloseGpio()
 {
+  m_gpioPins.Close();
+
   std::string filename = m_path + "/unexport";
   std::ofstream unexportFile(filename, std::ofstream::out);
   
@@ -206,14 +286,31 @@ void Gpio::Reset()
   for (uint16_t i = 0; i < m_pins.size(); i++) {
     uint16_t pin = m_pins[i];
     bool initialValue = m_initialValuesDirections[i].first;
-    std::string initialDirection = m_initialValuesDirections[i].second;
-    SetDirection(pin, initialDirection);
-    if (initialDirection.compare("out") == 0) {
+    if (m_gpioPins.IsOutput(pin)) {
       SetValue(pin, initialValue);
     }
   }
 }
 
+/**
+ * Sets outputs that have not been requested within the watchdog timeout to
+ * their safe values. Each output is set once until it is requested again.
+ */
+void Gpio::CheckWatchdog()
+{
+  std::vector<uint16_t> expired;
+  {
+    odcore::base::Lock l(m_mutex);
+    m_gpioPins.CheckWatchdog(m_watchdogTimeout, 
+        std::chrono::steady_clock::now(), expired);
+  }
+  for (uint16_t pin : expired) {
+    cerr << "[" << getName() << "] No request for pin " << pin 
+        << " within the watchdog timeout, setting it to its safe value." 
+        << std::endl;
+  }
+}
+
 void Gpio::SetDirection(uint16_t const a_pin, std::string const a_str)
 {
   std::string gpioDirectionFilename = m_path + "/gpio" + std::to_string(a_pin) 
@@ -253,38 +350,20 @@ std::string Gpio::GetDirection(uint16_t const a_pin) const
 
 void Gpio::SetValue(uint16_t const a_pin, bool const a_value)
 {
-  std::string gpioValueFilename = 
-      m_path + "/gpio" + std::to_string(a_pin) + "/value";
-
-  std::ofstream gpioValueFile(gpioValueFilename, std::ofstream::out);
-  if (gpioValueFile.is_open()) {
-    gpioValueFile << static_cast<uint16_t>(a_value);
-    gpioValueFile.flush();
-  } else {
-    cerr << "[" << getName() << "] Could not open " << gpioValueFilename 
+  if (!m_gpioPins.SetValue(a_pin, a_value)) {
+    cerr << "[" << getName() << "] Could not write value of pin " << a_pin 
         << "." << std::endl;
   }
-  gpioValueFile.close();
 }
 
 bool Gpio::GetValue(uint16_t const a_pin) const
 {
-  std::string gpioValueFilename = 
-      m_path + "/gpio" + std::to_string(a_pin) + "/value";
-  std::string line;
-
-  std::ifstream gpioValueFile(gpioValueFilename, std::ifstream::in);
-  if (gpioValueFile.is_open()) {
-    std::getline(gpioValueFile, line);
-    bool value = (std::stoi(line) == 1);
-    gpioValueFile.close();
-    return value;
-  } else {
-    cerr << "[" << getName() << "] Could not open " << gpioValueFilename 
+  bool value = false;
+  if (!m_gpioPins.GetValue(a_pin, value)) {
+    cerr << "[" << getName() << "] Could not read value of pin " << a_pin 
         << "." << std::endl;
-    gpioValueFile.close();
-    return NULL;
   }
+  return value;
 }
 
 }
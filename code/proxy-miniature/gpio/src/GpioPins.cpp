@@ -0,0 +1,211 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "GpioPins.h"
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+GpioPins::GpioPins()
+    : m_pins()
+    , m_writes(0)
+{
+}
+
+GpioPins::Pin::Pin()
+    : isOutput(false)
+    , valueFd(-1)
+    , lastValue(-1)
+    , safeValue(false)
+    , isSafe(false)
+    , requestTime(std::chrono::steady_clock::now())
+{
+}
+
+GpioPins::~GpioPins()
+{
+  Close();
+}
+
+/**
+ * Opens the value file of an exported pin, for writing if it is an output.
+ * A pin whose file could not be opened is still known, but fails every 
+ * read and write.
+ */
+bool GpioPins::Open(uint16_t const a_pin, std::string const &a_filename, 
+    bool const a_isOutput)
+{
+  auto entry = m_pins.find(a_pin);
+  if (entry != m_pins.end() && entry->second.valueFd >= 0) {
+    close(entry->second.valueFd);
+  }
+
+  Pin pin;
+  pin.isOutput = a_isOutput;
+  pin.valueFd = open(a_filename.c_str(), a_isOutput ? O_RDWR : O_RDONLY);
+  m_pins[a_pin] = pin;
+  return (pin.valueFd >= 0);
+}
+
+void GpioPins::Close()
+{
+  for (auto &entry : m_pins) {
+    if (entry.second.valueFd >= 0) {
+      close(entry.second.valueFd);
+    }
+  }
+  m_pins.clear();
+}
+
+bool GpioPins::HasPin(uint16_t const a_pin) const
+{
+  return (m_pins.find(a_pin) != m_pins.end());
+}
+
+bool GpioPins::IsOutput(uint16_t const a_pin) const
+{
+  auto entry = m_pins.find(a_pin);
+  return (entry != m_pins.end() && entry->second.isOutput);
+}
+
+bool GpioPins::SetSafeValue(uint16_t const a_pin, bool const a_value)
+{
+  auto entry = m_pins.find(a_pin);
+  if (entry == m_pins.end()) {
+    return false;
+  }
+  entry->second.safeValue = a_value;
+  return true;
+}
+
+/**
+ * Sets an output as requested, which also rearms its watchdog.
+ */
+bool GpioPins::Request(uint16_t const a_pin, bool const a_value)
+{
+  auto entry = m_pins.find(a_pin);
+  if (entry == m_pins.end() || !entry->second.isOutput) {
+    return false;
+  }
+  Pin &pin = entry->second;
+  pin.requestTime = std::chrono::steady_clock::now();
+  pin.isSafe = false;
+  return Write(pin, a_value);
+}
+
+bool GpioPins::SetValue(uint16_t const a_pin, bool const a_value)
+{
+  auto entry = m_pins.find(a_pin);
+  if (entry == m_pins.end() || !entry->second.isOutput) {
+    return false;
+  }
+  return Write(entry->second, a_value);
+}
+
+bool GpioPins::GetValue(uint16_t const a_pin, bool &a_value) const
+{
+  auto entry = m_pins.find(a_pin);
+  if (entry == m_pins.end() || entry->second.valueFd < 0) {
+    return false;
+  }
+
+  char valueChar = '0';
+  if (pread(entry->second.valueFd, &valueChar, 1, 0) != 1) {
+    return false;
+  }
+  a_value = (valueChar == '1');
+  return true;
+}
+
+/**
+ * Sets outputs that have not been requested within the timeout before the
+ * given time to their safe values, and returns them. Each output is set 
+ * once until it is requested again. A timeout of zero disables the 
+ * watchdog.
+ */
+uint32_t GpioPins::CheckWatchdog(std::chrono::milliseconds const a_timeout,
+    std::chrono::steady_clock::time_point const &a_now, 
+    std::vector<uint16_t> &a_expired)
+{
+  a_expired.clear();
+  if (a_timeout.count() == 0) {
+    return 0;
+  }
+
+  for (auto &entry : m_pins) {
+    Pin &pin = entry.second;
+    if (!pin.isOutput || pin.isSafe || a_now - pin.requestTime < a_timeout) {
+      continue;
+    }
+    Write(pin, pin.safeValue);
+    pin.isSafe = true;
+    a_expired.push_back(entry.first);
+  }
+  return static_cast<uint32_t>(a_expired.size());
+}
+
+/**
+ * Sets all outputs to their safe values.
+ */
+void GpioPins::SetSafe()
+{
+  for (auto &entry : m_pins) {
+    Pin &pin = entry.second;
+    if (pin.isOutput) {
+      Write(pin, pin.safeValue);
+      pin.isSafe = true;
+    }
+  }
+}
+
+uint32_t GpioPins::GetWrites() const
+{
+  return m_writes;
+}
+
+bool GpioPins::Write(Pin &a_pin, bool const a_value)
+{
+  if (a_pin.valueFd < 0) {
+    return false;
+  }
+  int8_t const value = static_cast<int8_t>(a_value);
+  if (a_pin.lastValue == value) {
+    return true;
+  }
+
+  char const valueChar = a_value ? '1' : '0';
+  if (pwrite(a_pin.valueFd, &valueChar, 1, 0) != 1) {
+    return false;
+  }
+  a_pin.lastValue = value;
+  m_writes++;
+  return true;
+}
+
+}
+}
+}
@@ -20,14 +20,21 @@
 #ifndef GPIO_TESTSUITE_H
 #define GPIO_TESTSUITE_H
 
+#include <chrono>
+#include <string>
+#include <vector>
+
 #include "cxxtest/TestSuite.h"
 
 // Include local header files.
 #include "../include/Gpio.h"
+#include "../include/GpioPins.h"
+#include "../../../common-miniature/testsuites/TemporaryDirectory.h"
 
 using namespace std;
 using namespace odcore::data;
 using namespace opendlv::proxy::miniature;
+using opendlv::common::miniature::TemporaryDirectory;
 
 /**
  * This class derives from SensorBoard to allow access to protected methods.
@@ -75,6 +82,113 @@ class GpioTest : public CxxTest::TestSuite {
     TS_ASSERT(dt != NULL);
   }
 
+  void testPinsTableKnowsOnlyOpenedPins() {
+    TemporaryDirectory directory("gpiotest");
+    WritePinFiles(directory, 2);
+
+    GpioPins pins;
+    TS_ASSERT(pins.Open(30, directory.GetPath() + "/value0", true));
+    TS_ASSERT(pins.Open(31, directory.GetPath() + "/value1", false));
+    TS_ASSERT(!pins.Open(32, directory.GetPath() + "/missing", true));
+
+    TS_ASSERT(pins.HasPin(30));
+    TS_ASSERT(pins.IsOutput(30));
+    TS_ASSERT(!pins.IsOutput(31));
+    TS_ASSERT(!pins.HasPin(33));
+    TS_ASSERT(!pins.IsOutput(33));
+
+    // Pins that are not in the table are not added by using them.
+    TS_ASSERT(!pins.SetSafeValue(33, true));
+    TS_ASSERT(!pins.SetValue(33, true));
+    TS_ASSERT(!pins.Request(33, true));
+    TS_ASSERT(!pins.HasPin(33));
+
+    // Inputs are never written, and a pin without a file fails.
+    TS_ASSERT(!pins.Request(31, true));
+    TS_ASSERT(!pins.Request(32, true));
+    bool value = true;
+    TS_ASSERT(pins.GetValue(31, value));
+    TS_ASSERT(!value);
+    TS_ASSERT(!pins.GetValue(32, value));
+
+    pins.Close();
+    TS_ASSERT(!pins.HasPin(30));
+  }
+
+  void testPinsSuppressUnchangedWrites() {
+    TemporaryDirectory directory("gpiotest");
+    WritePinFiles(directory, 1);
+
+    GpioPins pins;
+    TS_ASSERT(pins.Open(30, directory.GetPath() + "/value0", true));
+
+    TS_ASSERT(pins.Request(30, true));
+    TS_ASSERT_EQUALS(directory.ReadFile("value0"), "1");
+    TS_ASSERT_EQUALS(pins.GetWrites(), 1u);
+
+    // The same value is not written again, whichever way it is set.
+    TS_ASSERT(pins.Request(30, true));
+    TS_ASSERT(pins.SetValue(30, true));
+    TS_ASSERT_EQUALS(pins.GetWrites(), 1u);
+
+    TS_ASSERT(pins.Request(30, false));
+    TS_ASSERT_EQUALS(directory.ReadFile("value0"), "0");
+    TS_ASSERT_EQUALS(pins.GetWrites(), 2u);
+    bool value = true;
+    TS_ASSERT(pins.GetValue(30, value));
+    TS_ASSERT(!value);
+  }
+
+  void testPinsWatchdogFallsBackToSafeValue() {
+    TemporaryDirectory directory("gpiotest");
+    WritePinFiles(directory, 2);
+
+    GpioPins pins;
+    TS_ASSERT(pins.Open(30, directory.GetPath() + "/value0", true));
+    TS_ASSERT(pins.Open(31, directory.GetPath() + "/value1", false));
+    TS_ASSERT(pins.SetSafeValue(30, false));
+
+    // The watchdog is checked at times taken before a request, when it 
+    // cannot have expired, or a timeout after it, when it must have.
+    std::chrono::milliseconds const timeout(20);
+    std::vector<uint16_t> expired;
+    std::chrono::steady_clock::time_point requested = 
+        std::chrono::steady_clock::now();
+    TS_ASSERT(pins.Request(30, true));
+    std::chrono::steady_clock::time_point const late = 
+        std::chrono::steady_clock::now() + timeout;
+    TS_ASSERT_EQUALS(pins.CheckWatchdog(timeout, requested, expired), 0u);
+
+    // A zero timeout disables the watchdog.
+    TS_ASSERT_EQUALS(pins.CheckWatchdog(std::chrono::milliseconds(0), late,
+          expired), 0u);
+    TS_ASSERT_EQUALS(directory.ReadFile("value0"), "1");
+
+    // Only the output expires, once, and is set to its safe value.
+    TS_ASSERT_EQUALS(pins.CheckWatchdog(timeout, late, expired), 1u);
+    TS_ASSERT_EQUALS(expired.size(), 1u);
+    TS_ASSERT_EQUALS(expired[0], 30);
+    TS_ASSERT_EQUALS(directory.ReadFile("value0"), "0");
+    TS_ASSERT_EQUALS(pins.CheckWatchdog(timeout, late, expired), 0u);
+
+    // A fresh request rearms the watchdog.
+    requested = std::chrono::steady_clock::now();
+    TS_ASSERT(pins.Request(30, true));
+    TS_ASSERT_EQUALS(pins.CheckWatchdog(timeout, requested, expired), 0u);
+    TS_ASSERT_EQUALS(directory.ReadFile("value0"), "1");
+
+    pins.SetSafe();
+    TS_ASSERT_EQUALS(directory.ReadFile("value0"), "0");
+    TS_ASSERT_EQUALS(directory.ReadFile("value1"), "0");
+  }
+
+ private:
+  void WritePinFiles(TemporaryDirectory &a_directory, uint32_t a_count) {
+    for (uint32_t i = 0; i < a_count; i++) {
+      a_directory.WriteFile("value" + std::to_string(i), "0");
+    }
+  }
+
   ////////////////////////////////////////////////////////////////////////////////////
   // Below this line the necessary constructor for initializing the pointer variables,
   // and the forbidden copy constructor and assignment operator are declared.
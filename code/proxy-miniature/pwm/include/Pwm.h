@@ -26,16 +26,22 @@
 #include <vector>
 #include <utility>
 
-#include <opendavinci/odcore/base/module/DataTriggeredConferenceClientModule.h>
+#include <opendavinci/odcore/base/Mutex.h>
+#include <opendavinci/odcore/base/module/TimeTriggeredConferenceClientModule.h>
+
+#include <odvdminiature/GeneratedHeaders_ODVDMiniature.h>
+
+#include "PwmChannels.h"
 
 namespace opendlv {
 namespace proxy {
 namespace miniature {
 
 /**
- * Interface to PWM.
+ * Interface to PWM. Requests are staged as they arrive and written to the
+ * hardware once per time slice.
  */
-class Pwm : public odcore::base::module::DataTriggeredConferenceClientModule {
+class Pwm : public odcore::base::module::TimeTriggeredConferenceClientModule {
  public:
   Pwm(const int &, char **);
   Pwm(const Pwm &) = delete;
@@ -43,9 +49,18 @@ class Pwm : public odcore::base::module::DataTriggeredConferenceClientModule {
   virtual ~Pwm();
   virtual void nextContainer(odcore::data::Container &);
 
+ protected:
+  bool OpenChannel(uint16_t const, std::string const &);
+  bool SetRampStep(uint16_t const, uint32_t const);
+  void StageRequest(opendlv::proxy::PwmRequest const &);
+  void StageRequests(opendlv::proxy::PwmRequests const &);
+  void Tick();
+  PwmChannels const &GetChannels() const;
+
  private:
   void setUp();
   void tearDown();
+  virtual odcore::data::dmcp::ModuleExitCodeMessage::ModuleExitCode body();
 
   void OpenPwm();
   void ClosePwm();
@@ -57,6 +72,8 @@ class Pwm : public odcore::base::module::DataTriggeredConferenceClientModule {
   void SetPeriodNs(uint16_t const, uint32_t const);
   uint32_t GetPeriodNs(uint16_t const) const;
 
+  odcore::base::Mutex m_mutex;
+  PwmChannels m_channels;
   bool m_debug;
   bool m_initialised;
   std::string m_path;
@@ -0,0 +1,84 @@
+/**
+ * proxy-miniature-pwm - Interface to pwm.
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PROXY_MINIATURE_PWMCHANNELS_H
+#define PROXY_MINIATURE_PWMCHANNELS_H
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+/**
+ * Keeps the duty cycle files of a set of PWM channels open. Requested duty
+ * cycles are staged per channel and written in one pass by Flush, so only
+ * the latest request for each channel reaches the hardware.
+ */
+class PwmChannels {
+ public:
+  PwmChannels();
+  PwmChannels(PwmChannels const &) = delete;
+  PwmChannels &operator=(PwmChannels const &) = delete;
+  virtual ~PwmChannels();
+
+  bool Open(uint16_t const, std::string const &);
+  void Close();
+  bool HasChannel(uint16_t const) const;
+  bool SetRampStep(uint16_t const, uint32_t const);
+  bool SetWatchdog(uint16_t const, uint32_t const, uint32_t const);
+  uint32_t CheckWatchdogs(std::chrono::steady_clock::time_point const &);
+  void StageSafe();
+  bool Stage(uint16_t const, uint32_t const);
+  uint32_t Flush();
+  uint32_t GetFailedWrites() const;
+  bool GetWriteTime(uint16_t const, 
+      std::chrono::steady_clock::time_point &) const;
+
+ private:
+  struct Channel {
+    Channel();
+    int32_t fd;
+    uint32_t writtenDutyCycleNs;
+    uint32_t stagedDutyCycleNs;
+    uint32_t rampStepNs;
+    uint32_t safeDutyCycleNs;
+    std::chrono::milliseconds watchdogTimeout;
+    std::chrono::steady_clock::time_point stageTime;
+    std::chrono::steady_clock::time_point writeTime;
+    bool isWritten;
+    bool isStaged;
+    bool isSafe;
+  };
+
+  bool Write(Channel &, uint32_t const);
+
+  std::vector<Channel> m_channels;
+  std::unordered_map<uint16_t, uint32_t> m_channelIndices;
+  uint32_t m_failedWrites;
+};
+
+}
+}
+}
+
+#endif
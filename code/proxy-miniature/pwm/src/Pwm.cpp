@@ -17,12 +17,14 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  */
 
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
 
 #include <opendavinci/odcore/base/KeyValueConfiguration.h>
+#include <opendavinci/odcore/base/Lock.h>
 #include <opendavinci/odcore/data/Container.h>
 #include <opendavinci/odcore/strings/StringToolbox.h>
 
@@ -35,7 +37,9 @@ namespace proxy {
 namespace miniature {
 
 Pwm::Pwm(const int &argc, char **argv)
-    : DataTriggeredConferenceClientModule(argc, argv, "proxy-miniature-pwm")
+    : TimeTriggeredConferenceClientModule(argc, argv, "proxy-miniature-pwm")
+    , m_mutex()
+    , m_channels()
     , m_debug()
     , m_initialised()
     , m_path()
@@ -98,12 +102,80 @@ void Pwm::setUp()
 
   OpenPwm();
 
+  // Optional slew rates make the duty cycles ramp toward requested values 
+  // in equal steps, one per time slice, instead of jumping to them.
+  bool valueFound;
+  std::string const slewRatesString = kv.getOptionalValue<std::string>(
+      "proxy-miniature-pwm.slewRatesNsPerSecond", valueFound);
+  if (valueFound) {
+    std::vector<std::string> slewRatesVector = 
+        odcore::strings::StringToolbox::split(slewRatesString, ',');
+    if (slewRatesVector.size() == m_pins.size()) {
+      for (uint32_t i = 0; i < m_pins.size(); i++) {
+        uint32_t slewRateNsPerSecond = std::stoi(slewRatesVector.at(i));
+        uint32_t rampStepNs = static_cast<uint32_t>(
+            slewRateNsPerSecond / getFrequency());
+        if (slewRateNsPerSecond > 0 && rampStepNs == 0) {
+          rampStepNs = 1;
+        }
+        SetRampStep(m_pins.at(i), rampStepNs);
+        if (m_debug) {
+          std::cout << "[" << getName() << "] Pin " << m_pins.at(i) 
+              << " ramps " << rampStepNs << " ns per time slice." 
+              << std::endl;
+        }
+      }
+    } else {
+      cerr << "[" << getName() 
+          << "] Number of pins do not equals to number of slew rates." 
+          << std::endl;
+    }
+  }
+
+  // Safe duty cycles are written at tearDown and, with the optional 
+  // watchdog, when no request has arrived within the timeout. The initial
+  // duty cycles are used unless others are given.
+  std::vector<uint32_t> safeDutyCyclesNs = m_dutyCyclesNs;
+  std::string const safeDutyCyclesString = kv.getOptionalValue<std::string>(
+      "proxy-miniature-pwm.safeDutyCyclesNs", valueFound);
+  if (valueFound) {
+    std::vector<std::string> safeDutyCyclesVector = 
+        odcore::strings::StringToolbox::split(safeDutyCyclesString, ',');
+    if (safeDutyCyclesVector.size() == m_pins.size()) {
+      for (uint32_t i = 0; i < m_pins.size(); i++) {
+        safeDutyCyclesNs[i] = std::stoi(safeDutyCyclesVector.at(i));
+      }
+    } else {
+      cerr << "[" << getName() 
+          << "] Number of pins do not equals to number of safe duty cycles." 
+          << std::endl;
+    }
+  }
+  uint32_t watchdogTimeoutMs = kv.getOptionalValue<uint32_t>(
+      "proxy-miniature-pwm.watchdogTimeoutMs", valueFound);
+  if (!valueFound) {
+    watchdogTimeoutMs = 0;
+  }
+  for (uint32_t i = 0; i < m_pins.size() && i < safeDutyCyclesNs.size(); i++) {
+    m_channels.SetWatchdog(m_pins.at(i), watchdogTimeoutMs, 
+        safeDutyCyclesNs.at(i));
+  }
+
   m_initialised = true;
 }
 
 void Pwm::tearDown()
 {
-//  ClosePwm();
+  ClosePwm();
+}
+
+odcore::data::dmcp::ModuleExitCodeMessage::ModuleExitCode Pwm::body()
+{
+  while (getModuleStateAndWaitForRemainingTimeInTimeslice() == 
+      odcore::data::dmcp::ModuleStateMessage::RUNNING) {
+    Tick();
+  }
+  return odcore::data::dmcp::ModuleExitCodeMessage::OKAY;
 }
 
 void Pwm::nextContainer(odcore::data::Container &a_container)
@@ -113,14 +185,88 @@ void Pwm::nextContainer(odcore::data::Container &a_container)
   }
   if (a_container.getDataType() == opendlv::proxy::PwmRequest::ID() &&
       a_container.getSenderStamp() == getIdentifier()) {
-    opendlv::proxy::PwmRequest request = 
-        a_container.getData<opendlv::proxy::PwmRequest>();
-    uint16_t pin = request.getPin();
-    uint32_t dutyCycleNs = request.getDutyCycleNs();
-    SetDutyCycleNs(pin, dutyCycleNs);
+    StageRequest(a_container.getData<opendlv::proxy::PwmRequest>());
+  } else if (a_container.getDataType() == opendlv::proxy::PwmRequests::ID() &&
+      a_container.getSenderStamp() == getIdentifier()) {
+    StageRequests(a_container.getData<opendlv::proxy::PwmRequests>());
+  }
+}
+
+bool Pwm::OpenChannel(uint16_t const a_pin, std::string const &a_filename)
+{
+  odcore::base::Lock l(m_mutex);
+  return m_channels.Open(a_pin, a_filename);
+}
+
+bool Pwm::SetRampStep(uint16_t const a_pin, uint32_t const a_rampStepNs)
+{
+  odcore::base::Lock l(m_mutex);
+  return m_channels.SetRampStep(a_pin, a_rampStepNs);
+}
+
+void Pwm::StageRequest(opendlv::proxy::PwmRequest const &a_request)
+{
+  uint16_t pin = a_request.getPin();
+  uint32_t dutyCycleNs = a_request.getDutyCycleNs();
+
+  odcore::base::Lock l(m_mutex);
+  if (!m_channels.Stage(pin, dutyCycleNs)) {
+    cerr << "[" << getName() << "] The requested pin " << pin
+        << " is not exported." << std::endl;
   }
 }
 
+/**
+ * Stages all channels of a request under one lock, so that the next time 
+ * slice writes them together and never only some of them.
+ */
+void Pwm::StageRequests(opendlv::proxy::PwmRequests const &a_requests)
+{
+  std::vector<uint16_t> pins = a_requests.getListOfPins();
+  std::vector<uint32_t> dutyCyclesNs = a_requests.getListOfDutyCyclesNs();
+  if (pins.size() != dutyCyclesNs.size()) {
+    cerr << "[" << getName() 
+        << "] Number of pins do not equals to number of duty cycles." 
+        << std::endl;
+    return;
+  }
+
+  odcore::base::Lock l(m_mutex);
+  for (uint32_t i = 0; i < pins.size(); i++) {
+    if (!m_channels.Stage(pins[i], dutyCyclesNs[i])) {
+      cerr << "[" << getName() << "] The requested pin " << pins[i]
+          << " is not exported." << std::endl;
+    }
+  }
+}
+
+/**
+ * Writes what was staged since the previous time slice, in one pass. This 
+ * is the only place duty cycles are written while running, so ramping 
+ * channels move one step per time slice.
+ */
+void Pwm::Tick()
+{
+  odcore::base::Lock l(m_mutex);
+  uint32_t expiredCount = 
+      m_channels.CheckWatchdogs(std::chrono::steady_clock::now());
+  if (expiredCount > 0) {
+    cerr << "[" << getName() << "] No request within the watchdog timeout, " 
+        << expiredCount << " channels set to safe duty cycles." << std::endl;
+  }
+  uint32_t writeCount = m_channels.Flush();
+  if (m_debug && writeCount > 0) {
+    std::cout << "[" << getName() << "] Wrote " << writeCount 
+        << " duty cycles (" << m_channels.GetFailedWrites() 
+        << " failed writes in total)." << std::endl;
+  }
+}
+
+PwmChannels const &Pwm::GetChannels() const
+{
+  return m_channels;
+}
+
 void Pwm::OpenPwm()
 {
   std::string filename = m_path + "/export";
@@ -131,6 +277,14 @@ void Pwm::OpenPwm()
       exportFile << pin;
       exportFile.flush();
     }
+    for (auto pin : m_pins) {
+      std::string dutyCycleFilename = 
+          m_path + "/pwm" + std::to_string(pin) + "/duty_cycle";
+      if (!OpenChannel(pin, dutyCycleFilename)) {
+        cerr << "[" << getName() << "] Could not open " << dutyCycleFilename 
+            << "." << std::endl;
+      }
+    }
     Reset();
   } else {
     cerr << "[" << getName() << "] Could not open " << filename << "." 
@@ -141,20 +295,15 @@ void Pwm::OpenPwm()
 
 void Pwm::ClosePwm()
 {
-  std::string filename = m_path + "/unexport";
-  std::ofstream unexportFile(filename, std::ofstream::out);
-  
-  if (unexportFile.is_open()) {
-    for (auto pin : m_pins) {
-      SetEnabled(pin, 0);
-      unexportFile << pin;
-      unexportFile.flush();
-    }
-  } else {
-    cerr << "[" << getName() << "] Could not open " << filename << "." 
-        << std::endl;
+  // The pins stay exported, but are left at their safe duty cycles with the
+  // outputs disabled.
+  odcore::base::Lock l(m_mutex);
+  m_channels.StageSafe();
+  m_channels.Flush();
+  for (auto pin : m_pins) {
+    SetEnabled(pin, false);
   }
-  unexportFile.close();
+  m_channels.Close();
 }
 
 void Pwm::Reset()
@@ -202,18 +351,12 @@ bool Pwm::GetEnabled(uint16_t const a_pin) const
 
 void Pwm::SetDutyCycleNs(uint16_t const a_pin, uint32_t const a_value)
 {
-  std::string filename = m_path + "/pwm" + std::to_string(a_pin) + "/duty_cycle";
-
-  std::ofstream file(filename, std::ofstream::out);
-  if (file.is_open()) {
-    file << std::to_string(a_value);
-    file.flush();
+  if (m_channels.Stage(a_pin, a_value)) {
+    m_channels.Flush();
   } else {
-    cerr << "[" << getName() << "] Could not open " << filename 
-        << "." << std::endl;
+    cerr << "[" << getName() << "] Pin " << a_pin 
+        << " has no open duty cycle file." << std::endl;
   }
-
-  file.close();
 }
 
 uint32_t Pwm::GetDutyCycleNs(uint16_t const a_pin) const
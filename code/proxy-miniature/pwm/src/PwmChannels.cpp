@@ -0,0 +1,255 @@
+/**
+ * proxy-miniature-pwm - Interface to pwm.
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "PwmChannels.h"
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+PwmChannels::PwmChannels()
+    : m_channels()
+    , m_channelIndices()
+    , m_failedWrites(0)
+{
+}
+
+PwmChannels::Channel::Channel()
+    : fd(-1)
+    , writtenDutyCycleNs(0)
+    , stagedDutyCycleNs(0)
+    , rampStepNs(0)
+    , safeDutyCycleNs(0)
+    , watchdogTimeout(0)
+    , stageTime(std::chrono::steady_clock::now())
+    , writeTime()
+    , isWritten(false)
+    , isStaged(false)
+    , isSafe(false)
+{
+}
+
+PwmChannels::~PwmChannels()
+{
+  Close();
+}
+
+bool PwmChannels::Open(uint16_t const a_pin, std::string const &a_filename)
+{
+  if (HasChannel(a_pin)) {
+    return true;
+  }
+
+  int32_t fd = open(a_filename.c_str(), O_WRONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  Channel channel;
+  channel.fd = fd;
+
+  m_channelIndices[a_pin] = static_cast<uint32_t>(m_channels.size());
+  m_channels.push_back(channel);
+  return true;
+}
+
+void PwmChannels::Close()
+{
+  for (Channel &channel : m_channels) {
+    close(channel.fd);
+  }
+  m_channels.clear();
+  m_channelIndices.clear();
+}
+
+bool PwmChannels::HasChannel(uint16_t const a_pin) const
+{
+  return (m_channelIndices.find(a_pin) != m_channelIndices.end());
+}
+
+/**
+ * Limits how far the duty cycle of a channel may move per flush. A step of
+ * zero writes staged duty cycles directly.
+ */
+bool PwmChannels::SetRampStep(uint16_t const a_pin, 
+    uint32_t const a_rampStepNs)
+{
+  auto index = m_channelIndices.find(a_pin);
+  if (index == m_channelIndices.end()) {
+    return false;
+  }
+  m_channels[index->second].rampStepNs = a_rampStepNs;
+  return true;
+}
+
+/**
+ * Sets the safe duty cycle a channel falls back to when nothing has been
+ * staged for it within the timeout. A timeout of zero disables the watchdog.
+ */
+bool PwmChannels::SetWatchdog(uint16_t const a_pin, uint32_t const a_timeoutMs,
+    uint32_t const a_safeDutyCycleNs)
+{
+  auto index = m_channelIndices.find(a_pin);
+  if (index == m_channelIndices.end()) {
+    return false;
+  }
+  Channel &channel = m_channels[index->second];
+  channel.watchdogTimeout = std::chrono::milliseconds(a_timeoutMs);
+  channel.safeDutyCycleNs = a_safeDutyCycleNs;
+  channel.stageTime = std::chrono::steady_clock::now();
+  return true;
+}
+
+/**
+ * Stages the safe duty cycle for every channel whose last request is older
+ * than its timeout at the given time. Returns the number of channels that 
+ * expired since the previous check.
+ */
+uint32_t PwmChannels::CheckWatchdogs(
+    std::chrono::steady_clock::time_point const &a_now)
+{
+  uint32_t expiredCount = 0;
+  for (Channel &channel : m_channels) {
+    if (channel.isSafe || channel.watchdogTimeout.count() == 0 
+        || a_now - channel.stageTime < channel.watchdogTimeout) {
+      continue;
+    }
+    channel.stagedDutyCycleNs = channel.safeDutyCycleNs;
+    channel.isStaged = true;
+    channel.isSafe = true;
+    expiredCount++;
+  }
+  return expiredCount;
+}
+
+/**
+ * Stages the safe duty cycle for all channels.
+ */
+void PwmChannels::StageSafe()
+{
+  for (Channel &channel : m_channels) {
+    channel.stagedDutyCycleNs = channel.safeDutyCycleNs;
+    channel.isStaged = true;
+    channel.isSafe = true;
+  }
+}
+
+/**
+ * Stages a duty cycle to be written at the next flush. A later request for
+ * the same channel replaces an earlier one that was not yet flushed.
+ */
+bool PwmChannels::Stage(uint16_t const a_pin, uint32_t const a_dutyCycleNs)
+{
+  auto index = m_channelIndices.find(a_pin);
+  if (index == m_channelIndices.end()) {
+    return false;
+  }
+
+  Channel &channel = m_channels[index->second];
+  channel.stagedDutyCycleNs = a_dutyCycleNs;
+  channel.stageTime = std::chrono::steady_clock::now();
+  channel.isStaged = true;
+  channel.isSafe = false;
+  return true;
+}
+
+/**
+ * Writes all staged duty cycles back-to-back. Channels whose staged value
+ * equals what was last written are skipped, and ramping channels are moved
+ * one step toward their staged value. Returns the number of writes.
+ */
+uint32_t PwmChannels::Flush()
+{
+  uint32_t writeCount = 0;
+  for (Channel &channel : m_channels) {
+    if (!channel.isStaged) {
+      continue;
+    }
+    uint32_t const target = channel.stagedDutyCycleNs;
+    uint32_t const current = channel.writtenDutyCycleNs;
+    if (channel.isWritten && current == target) {
+      channel.isStaged = false;
+      continue;
+    }
+
+    // A ramping channel moves at most one step per flush and stays staged
+    // until the target is reached. The first write has nothing to ramp 
+    // from and goes straight to the target, as does a safe duty cycle.
+    uint32_t next = target;
+    if (channel.isWritten && channel.rampStepNs > 0 && !channel.isSafe) {
+      if (target > current && target - current > channel.rampStepNs) {
+        next = current + channel.rampStepNs;
+      } else if (current > target && current - target > channel.rampStepNs) {
+        next = current - channel.rampStepNs;
+      }
+    }
+    if (Write(channel, next)) {
+      writeCount++;
+    }
+    if (channel.isWritten && channel.writtenDutyCycleNs == target) {
+      channel.isStaged = false;
+    }
+  }
+  return writeCount;
+}
+
+uint32_t PwmChannels::GetFailedWrites() const
+{
+  return m_failedWrites;
+}
+
+/**
+ * Gives the time the duty cycle of a channel was last written.
+ */
+bool PwmChannels::GetWriteTime(uint16_t const a_pin, 
+    std::chrono::steady_clock::time_point &a_writeTime) const
+{
+  auto index = m_channelIndices.find(a_pin);
+  if (index == m_channelIndices.end()) {
+    return false;
+  }
+  a_writeTime = m_channels[index->second].writeTime;
+  return true;
+}
+
+bool PwmChannels::Write(Channel &a_channel, uint32_t const a_dutyCycleNs)
+{
+  char buffer[16];
+  int32_t length = snprintf(buffer, sizeof(buffer), "%u", a_dutyCycleNs);
+  if (pwrite(a_channel.fd, buffer, length, 0) != length) {
+    m_failedWrites++;
+    return false;
+  }
+  a_channel.writeTime = std::chrono::steady_clock::now();
+  a_channel.writtenDutyCycleNs = a_dutyCycleNs;
+  a_channel.isWritten = true;
+  return true;
+}
+
+}
+}
+}
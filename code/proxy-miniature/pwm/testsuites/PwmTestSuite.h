@@ -20,14 +20,22 @@
 #ifndef PWM_TESTSUITE_H
 #define PWM_TESTSUITE_H
 
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
 #include "cxxtest/TestSuite.h"
 
 // Include local header files.
 #include "../include/Pwm.h"
+#include "../include/PwmChannels.h"
+#include "../../../common-miniature/testsuites/TemporaryDirectory.h"
 
 using namespace std;
 using namespace odcore::data;
 using namespace opendlv::proxy::miniature;
+using opendlv::common::miniature::TemporaryDirectory;
 
 /**
  * This class derives from SensorBoard to allow access to protected methods.
@@ -41,6 +49,12 @@ class ProxyTestling : public Pwm {
         : Pwm(argc, argv) {}
 
     // Here, you need to add all methods which are protected in Pwm and which are needed for the test cases.
+    using Pwm::OpenChannel;
+    using Pwm::SetRampStep;
+    using Pwm::StageRequest;
+    using Pwm::StageRequests;
+    using Pwm::Tick;
+    using Pwm::GetChannels;
 };
 
 /**
@@ -75,6 +89,226 @@ class PwmTest : public CxxTest::TestSuite {
     TS_ASSERT(dt != NULL);
   }
 
+  void testChannelsCoalesceStagedDutyCycles() {
+    TemporaryDirectory directory("pwmtest");
+    WriteChannelFiles(directory, 2);
+
+    PwmChannels channels;
+    TS_ASSERT(channels.Open(0, directory.GetPath() + "/pwm0"));
+    TS_ASSERT(channels.Open(1, directory.GetPath() + "/pwm1"));
+    TS_ASSERT(!channels.Stage(2, 1500000));
+
+    TS_ASSERT(channels.Stage(0, 1000000));
+    TS_ASSERT(channels.Stage(0, 1200000));
+    TS_ASSERT(channels.Stage(1, 1700000));
+    TS_ASSERT_EQUALS(channels.Flush(), 2u);
+    TS_ASSERT_EQUALS(directory.ReadFile("pwm0"), "1200000");
+    TS_ASSERT_EQUALS(directory.ReadFile("pwm1"), "1700000");
+
+    // An unchanged duty cycle is not written again.
+    TS_ASSERT(channels.Stage(0, 1200000));
+    TS_ASSERT_EQUALS(channels.Flush(), 0u);
+    TS_ASSERT_EQUALS(channels.GetFailedWrites(), 0u);
+  }
+
+  void testChannelsRampTowardStagedDutyCycle() {
+    TemporaryDirectory directory("pwmtest");
+    WriteChannelFiles(directory, 1);
+
+    PwmChannels channels;
+    TS_ASSERT(channels.Open(0, directory.GetPath() + "/pwm0"));
+    TS_ASSERT(channels.SetRampStep(0, 100000));
+    TS_ASSERT(!channels.SetRampStep(1, 100000));
+
+    // The first write has nothing to ramp from.
+    TS_ASSERT(channels.Stage(0, 1500000));
+    TS_ASSERT_EQUALS(channels.Flush(), 1u);
+    TS_ASSERT_EQUALS(directory.ReadFile("pwm0"), "1500000");
+
+    TS_ASSERT(channels.Stage(0, 1750000));
+    TS_ASSERT_EQUALS(channels.Flush(), 1u);
+    TS_ASSERT_EQUALS(directory.ReadFile("pwm0"), "1600000");
+    TS_ASSERT_EQUALS(channels.Flush(), 1u);
+    TS_ASSERT_EQUALS(directory.ReadFile("pwm0"), "1700000");
+    TS_ASSERT_EQUALS(channels.Flush(), 1u);
+    TS_ASSERT_EQUALS(directory.ReadFile("pwm0"), "1750000");
+    TS_ASSERT_EQUALS(channels.Flush(), 0u);
+
+    // A new request mid-ramp reverses from the current duty cycle.
+    TS_ASSERT(channels.Stage(0, 1000000));
+    TS_ASSERT_EQUALS(channels.Flush(), 1u);
+    TS_ASSERT_EQUALS(directory.ReadFile("pwm0"), "1650000");
+    TS_ASSERT(channels.Stage(0, 1700000));
+    TS_ASSERT_EQUALS(channels.Flush(), 1u);
+    TS_ASSERT_EQUALS(directory.ReadFile("pwm0"), "1700000");
+    TS_ASSERT_EQUALS(channels.Flush(), 0u);
+  }
+
+  void testChannelsWatchdogFallsBackToSafeDutyCycle() {
+    TemporaryDirectory directory("pwmtest");
+    WriteChannelFiles(directory, 2);
+
+    PwmChannels channels;
+    TS_ASSERT(channels.Open(0, directory.GetPath() + "/pwm0"));
+    TS_ASSERT(channels.Open(1, directory.GetPath() + "/pwm1"));
+    TS_ASSERT(channels.SetRampStep(0, 100000));
+    TS_ASSERT(channels.SetWatchdog(0, 20, 1500000));
+    TS_ASSERT(channels.SetWatchdog(1, 0, 1500000));
+
+    // The watchdogs are checked at times taken before a request, when they
+    // cannot have expired, or a timeout after it, when they must have.
+    std::chrono::steady_clock::time_point requested = 
+        std::chrono::steady_clock::now();
+    TS_ASSERT(channels.Stage(0, 1800000));
+    TS_ASSERT(channels.Stage(1, 1800000));
+    std::chrono::steady_clock::time_point const late = 
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(20);
+    channels.Flush();
+    TS_ASSERT_EQUALS(channels.CheckWatchdogs(requested), 0u);
+
+    // Only the channel with a watchdog expires, once, and its safe duty 
+    // cycle is written without ramping.
+    TS_ASSERT_EQUALS(channels.CheckWatchdogs(late), 1u);
+    TS_ASSERT_EQUALS(channels.CheckWatchdogs(late), 0u);
+    TS_ASSERT_EQUALS(channels.Flush(), 1u);
+    TS_ASSERT_EQUALS(directory.ReadFile("pwm0"), "1500000");
+    TS_ASSERT_EQUALS(directory.ReadFile("pwm1"), "1800000");
+
+    // A fresh request rearms the watchdog.
+    requested = std::chrono::steady_clock::now();
+    TS_ASSERT(channels.Stage(0, 1600000));
+    channels.Flush();
+    TS_ASSERT_EQUALS(channels.CheckWatchdogs(requested), 0u);
+    TS_ASSERT_EQUALS(directory.ReadFile("pwm0"), "1600000");
+
+    channels.StageSafe();
+    TS_ASSERT_EQUALS(channels.Flush(), 2u);
+    TS_ASSERT_EQUALS(directory.ReadFile("pwm0"), "1500000");
+    TS_ASSERT_EQUALS(directory.ReadFile("pwm1"), "1500000");
+  }
+
+  void testModuleRampsOneStepPerTimeSlice() {
+    TemporaryDirectory directory("pwmtest");
+    WriteChannelFiles(directory, 2);
+    TS_ASSERT(dt->OpenChannel(0, directory.GetPath() + "/pwm0"));
+    TS_ASSERT(dt->OpenChannel(1, directory.GetPath() + "/pwm1"));
+    TS_ASSERT(dt->SetRampStep(0, 100000));
+    TS_ASSERT(dt->SetRampStep(1, 100000));
+
+    std::vector<uint16_t> pins;
+    pins.push_back(0);
+    pins.push_back(1);
+    std::vector<uint32_t> dutyCyclesNs(2, 1500000);
+    opendlv::proxy::PwmRequests requests;
+    requests.setListOfPins(pins);
+    requests.setListOfDutyCyclesNs(dutyCyclesNs);
+    dt->StageRequests(requests);
+    dt->Tick();
+    TS_ASSERT_EQUALS(directory.ReadFile("pwm0"), "1500000");
+
+    // However many requests arrive in a time slice, the channels move one 
+    // step per time slice, toward the latest request.
+    dutyCyclesNs.assign(2, 1800000);
+    requests.setListOfDutyCyclesNs(dutyCyclesNs);
+    for (uint32_t tick = 1; tick <= 3; tick++) {
+      for (uint32_t i = 0; i < 4; i++) {
+        dt->StageRequests(requests);
+        dt->StageRequest(opendlv::proxy::PwmRequest(1, 1800000));
+      }
+      TS_ASSERT_EQUALS(directory.ReadFile("pwm0"), 
+          std::to_string(1500000 + (tick - 1) * 100000));
+      dt->Tick();
+      TS_ASSERT_EQUALS(directory.ReadFile("pwm0"), 
+          std::to_string(1500000 + tick * 100000));
+      TS_ASSERT_EQUALS(directory.ReadFile("pwm1"), 
+          std::to_string(1500000 + tick * 100000));
+    }
+  }
+
+  void testModuleBatchedSkew() {
+    uint32_t const channelCount = 4;
+    uint32_t const iterations = 100;
+    TemporaryDirectory directory("pwmtest");
+    WriteChannelFiles(directory, channelCount);
+    for (uint16_t i = 0; i < channelCount; i++) {
+      TS_ASSERT(dt->OpenChannel(i, 
+            directory.GetPath() + "/pwm" + std::to_string(i)));
+    }
+
+    // When each channel comes as its own PwmRequest and the requests 
+    // straddle time slices, each time slice writes only the channels 
+    // requested so far, and the last channel lags the first by a time slice
+    // per channel. When all channels come in one PwmRequests, they are all
+    // written by the same time slice. The write skew within the time slices
+    // is only printed, as it depends on the load of the machine.
+    std::vector<int64_t> singleSkewsNs;
+    std::vector<int64_t> batchedSkewsNs;
+    for (uint32_t n = 0; n < iterations; n++) {
+      std::string const single = std::to_string(1000000 + 2 * n);
+      for (uint16_t i = 0; i < channelCount; i++) {
+        dt->StageRequest(opendlv::proxy::PwmRequest(i, 1000000 + 2 * n));
+        dt->Tick();
+        TS_ASSERT_EQUALS(CountChannels(directory, channelCount, single), 
+            i + 1u);
+      }
+      singleSkewsNs.push_back(GetWriteSkewNs(channelCount));
+
+      std::vector<uint16_t> pins;
+      std::vector<uint32_t> dutyCyclesNs;
+      for (uint16_t i = 0; i < channelCount; i++) {
+        pins.push_back(i);
+        dutyCyclesNs.push_back(1000001 + 2 * n);
+      }
+      opendlv::proxy::PwmRequests requests;
+      requests.setListOfPins(pins);
+      requests.setListOfDutyCyclesNs(dutyCyclesNs);
+      dt->StageRequests(requests);
+      dt->Tick();
+      TS_ASSERT_EQUALS(CountChannels(directory, channelCount, 
+            std::to_string(1000001 + 2 * n)), channelCount);
+      batchedSkewsNs.push_back(GetWriteSkewNs(channelCount));
+    }
+
+    std::cout << std::endl << "Median write skew over " << channelCount 
+        << " channels, single requests: " << Median(singleSkewsNs) 
+        << " ns over " << channelCount << " time slices, batched: " 
+        << Median(batchedSkewsNs) << " ns in one time slice." << std::endl;
+
+    TS_ASSERT_EQUALS(dt->GetChannels().GetFailedWrites(), 0u);
+  }
+
+ private:
+  void WriteChannelFiles(TemporaryDirectory &a_directory, uint32_t a_count) {
+    for (uint32_t i = 0; i < a_count; i++) {
+      a_directory.WriteFile("pwm" + std::to_string(i), "0");
+    }
+  }
+
+  uint32_t CountChannels(TemporaryDirectory const &a_directory, 
+      uint32_t a_count, std::string const &a_dutyCycleNs) {
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < a_count; i++) {
+      if (a_directory.ReadFile("pwm" + std::to_string(i)) == a_dutyCycleNs) {
+        count++;
+      }
+    }
+    return count;
+  }
+
+  int64_t GetWriteSkewNs(uint32_t a_channelCount) {
+    std::chrono::steady_clock::time_point first;
+    std::chrono::steady_clock::time_point last;
+    dt->GetChannels().GetWriteTime(0, first);
+    dt->GetChannels().GetWriteTime(a_channelCount - 1, last);
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        last - first).count();
+  }
+
+  int64_t Median(std::vector<int64_t> a_values) {
+    std::sort(a_values.begin(), a_values.end());
+    return a_values[a_values.size() / 2];
+  }
+
   ////////////////////////////////////////////////////////////////////////////////////
   // Below this line the necessary constructor for initializing the pointer variables,
   // and the forbidden copy constructor and assignment operator are declared.
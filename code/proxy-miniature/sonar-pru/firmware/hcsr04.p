@@ -16,14 +16,66 @@
 // PRU interrupt for PRU0
 #define PRU0_ARM_INTERRUPT 19
 
+// IEP timer counter, started by the host to count nanoseconds
+#define IEP_TMR_CNT 0x0C
+
+// PRU0 control registers, the cycle counter counts 5 ns cycles while enabled
+// and can only be written while disabled
+#define PRU0_CTRL 0x22000
+#define CTRL_CONTROL 0x00
+#define CTRL_CYCLE 0x0C
+#define COUNTER_ENABLE 3
+
+// Layout of the PRU0 data ram, shared with SonarPruMemory.h
+// 0x00: Number of sensors, written by the host
+// 0x04: Nanoseconds from one trigger to the next, written by the host
+// 0x10: One word per sensor, trigger bit in byte 0 and echo bit in byte 1
+// 0x40: Ring head, the next entry to write, owned by the PRU
+// 0x44: Ring tail, the next entry to read, owned by the host
+// 0x48: Number of samples dropped because the ring was full
+// 0x80: Ring entries of four words: sensor, echo width in cycles and the
+//       64 bit IEP time in nanoseconds when the sensor was triggered
+#define SENSOR_COUNT_OFFSET 0x00
+#define PERIOD_OFFSET 0x04
+#define SENSOR_CONFIG_OFFSET 0x10
+#define RING_HEAD_OFFSET 0x40
+#define RING_TAIL_OFFSET 0x44
+#define RING_DROPPED_OFFSET 0x48
+#define RING_OFFSET 0x80
+#define RING_SIZE 64
+#define MAX_SENSORS 8
+
+// Default sensor, used when the host gives no sensors
 // gpio1[12] P8_12 gpio44 0x030
 #define BIT_TRIGGER 0x0C
-
 // gpio1[13] P8_11 gpio45 0x034
 #define BIT_ECHO 0x0D
 
+// Number of polls of the echo pin before giving up on an echo that never
+// starts, roughly 20 ms
+#define ECHO_START_TIMEOUT 100000
+
+// Echoes longer than 40 ms (in cycles) are taken as no echo
+#define ECHO_END_TIMEOUT 8000000
+
+// Nanoseconds from one trigger to the next when the host gives no period,
+// long enough for the burst to decay in the environment
+#define DEFAULT_PERIOD 60000000
+
 #define delay r0
 #define roundtrip r4
+#define sensor r5
+#define sensorEnd r6
+#define triggerMask r7
+#define timeout r8
+#define config r10
+#define timeLo r11
+#define timeHi r12
+#define head r13
+#define ctrl r14
+#define echoStart r15
+#define echoLimit r16
+#define period r17
 
 
 START:
@@ -34,77 +86,176 @@ START:
 	LBCO r0, C4, 4, 4
 	CLR r0, r0, 4
 	SBCO r0, C4, 4, 4
-	
+
 	// Make constant 24 (c24) point to the beginning of PRU0 data ram
 	MOV r0, 0x00000000
 	MOV r1, 0x22020
 	SBBO r0, r1, 0, 4
-	
-	// Enable trigger as output and echo as input (clear BIT_TRIGGER and set BIT_ECHO of output enable)
+
+	// The host starts the IEP timer from zero before starting the firmware,
+	// and both extend it to 64 bits in the same way
+	MOV timeLo, 0
+	MOV timeHi, 0
+
+	MOV ctrl, PRU0_CTRL
+	MOV echoLimit, ECHO_END_TIMEOUT
+
+	// Measurements are paced by the IEP time, independent of the host
+	LBCO period, c24, PERIOD_OFFSET, 4
+	QBNE HAS_PERIOD, period, 0
+	MOV period, DEFAULT_PERIOD
+HAS_PERIOD:
+
+	// The host empties the ring before starting the firmware
+	LBCO head, c24, RING_HEAD_OFFSET, 4
+
+	// Read the number of sensors, at most MAX_SENSORS, and fall back to the
+	// default sensor if there are none
+	LBCO sensorEnd, c24, SENSOR_COUNT_OFFSET, 4
+	QBNE HAS_SENSORS, sensorEnd, 0
+	MOV config, BIT_TRIGGER | (BIT_ECHO << 8)
+	SBCO config, c24, SENSOR_CONFIG_OFFSET, 4
+	MOV sensorEnd, 1
+HAS_SENSORS:
+	QBGE COUNT_OK, sensorEnd, MAX_SENSORS
+	MOV sensorEnd, MAX_SENSORS
+COUNT_OK:
+	// Byte offset past the last sensor
+	LSL sensorEnd, sensorEnd, 2
+
+	// Enable triggers as outputs and echoes as inputs (clear the trigger bits
+	// and set the echo bits of output enable)
 	MOV r3, GPIO1 | GPIO_OE
 	LBBO r2, r3, 0, 4
-	CLR r2, BIT_TRIGGER
-	SET r2, BIT_ECHO
+	MOV sensor, 0
+CONFIGURE:
+	ADD r1, sensor, SENSOR_CONFIG_OFFSET
+	LBCO config, c24, r1, 4
+	CLR r2, r2, config.b0
+	SET r2, r2, config.b1
+	ADD sensor, sensor, 4
+	QBNE CONFIGURE, sensor, sensorEnd
 	SBBO r2, r3, 0, 4
 
+	// Sensors are fired one at a time, round-robin, so that an echo is never
+	// picked up by another sensor
+	MOV sensor, 0
+
 TRIGGER:
 
+	// Load the pins of the current sensor
+	ADD r1, sensor, SENSOR_CONFIG_OFFSET
+	LBCO config, c24, r1, 4
+	MOV r2, 1
+	LSL triggerMask, r2, config.b0
+
+	// Restart the cycle counter from zero
+	LBBO r1, ctrl, CTRL_CONTROL, 4
+	CLR r1, r1, COUNTER_ENABLE
+	SBBO r1, ctrl, CTRL_CONTROL, 4
+	MOV r2, 0
+	SBBO r2, ctrl, CTRL_CYCLE, 4
+	SET r1, r1, COUNTER_ENABLE
+	SBBO r1, ctrl, CTRL_CONTROL, 4
+
 	// Fire the sonar
 	// Set trigger pin to high
-	MOV r2, 1<<BIT_TRIGGER
 	MOV r3, GPIO1 | GPIO_SETDATAOUT
-	SBBO r2, r3, 0, 4
-	
-	// Delay 10 microseconds (200 MHz / 2 instructions = 10 ns per loop, 10 us = 1000 loops) 
+	SBBO triggerMask, r3, 0, 4
+
+	// Keep the trigger time, the 32 bit IEP time wraps every 4.3 s and is
+	// extended to 64 bits
+	LBCO r2, C26, IEP_TMR_CNT, 4
+	QBLE NO_WRAP, r2, timeLo
+	ADD timeHi, timeHi, 1
+NO_WRAP:
+	MOV timeLo, r2
+
+	// Delay 10 microseconds (200 MHz / 2 instructions = 10 ns per loop, 10 us = 1000 loops)
 	MOV delay, 1000
 TRIGGER_DELAY:
 	SUB delay, delay, 1
 	QBNE TRIGGER_DELAY, delay, 0
-	
+
 	// Set trigger pin to low
-	MOV r2, 1<<BIT_TRIGGER
 	MOV r3, GPIO1 | GPIO_CLEARDATAOUT
-	SBBO r2, r3, 0, 4
-	
-	// Wait for BIT_ECHO to go high, i.e. wait for the echo cycle to start
+	SBBO triggerMask, r3, 0, 4
+
+	// roundtrip measures the echo duration in cycles of 5 ns, zero means that
+	// no echo was measured
+	MOV roundtrip, 0
+
+	// Wait for the echo bit to go high, i.e. wait for the echo cycle to start
 	MOV r3, GPIO1 | GPIO_DATAIN
+	MOV timeout, ECHO_START_TIMEOUT
 WAIT_ECHO:
-	// Read the GPIO until BIT_ECHO goes high
+	SUB timeout, timeout, 1
+	QBEQ STORE, timeout, 0
+	// Read the GPIO until the echo bit goes high
 	LBBO r2, r3, 0, 4
-	QBBC WAIT_ECHO, r2, BIT_ECHO
-	
-	// roundtrip measures the echo duration in microseconds, resolution is 1us
-	MOV roundtrip, 0
+	QBBC WAIT_ECHO, r2, config.b1
+	LBBO echoStart, ctrl, CTRL_CYCLE, 4
 
 SAMPLE_ECHO:
 
-	// Delay 1 microsecond (adjusted because it takes time to query the GPIO pin)
-	MOV delay, 76
-SAMPLE_ECHO_DELAY:
-	SUB delay, delay, 1
-	QBNE SAMPLE_ECHO_DELAY, delay, 0
-	
-	// Add 1us to the roundtrip counter
-	ADD roundtrip, roundtrip, 1
-	
-	// Read GPIO until BIT_ECHO goes low
+	// Read GPIO and the cycle counter until the echo bit goes low, the width
+	// is the cycle count at the first low read
 	LBBO r2, r3, 0, 4
-	QBBS SAMPLE_ECHO, r2, BIT_ECHO
+	LBBO roundtrip, ctrl, CTRL_CYCLE, 4
+	SUB roundtrip, roundtrip, echoStart
+	QBLT NO_ECHO, roundtrip, echoLimit
+	QBBS SAMPLE_ECHO, r2, config.b1
+	JMP STORE
+
+NO_ECHO:
+	MOV roundtrip, 0
+
+STORE:
 
 	// Echo is complete
-	// Store the microsecond count in the PRUs data ram so C program can read it
-	SBCO roundtrip, c24, 0, 4
-	
+	// The ring is full if the entry after head is the tail, then the sample is
+	// dropped and counted
+	ADD r1, head, 1
+	AND r1, r1, RING_SIZE - 1
+	LBCO r9, c24, RING_TAIL_OFFSET, 4
+	QBNE PUSH, r1, r9
+	LBCO r9, c24, RING_DROPPED_OFFSET, 4
+	ADD r9, r9, 1
+	SBCO r9, c24, RING_DROPPED_OFFSET, 4
+	JMP PUSHED
+
+PUSH:
+	// Write the entry first and then publish it by moving head, so that the
+	// host never reads an entry that is being written
+	LSL r2, head, 4
+	ADD r2, r2, RING_OFFSET
+	LSR r9, sensor, 2
+	SBCO r9, c24, r2, 4
+	ADD r2, r2, 4
+	SBCO roundtrip, c24, r2, 4
+	ADD r2, r2, 4
+	SBCO timeLo, c24, r2, 8
+	MOV head, r1
+	SBCO head, c24, RING_HEAD_OFFSET, 4
+
 	// Trigger the PRU0 interrupt (C program gets the event)
 	MOV r31.b0, PRU0_ARM_INTERRUPT+16
-	
-	// Delay to allow sonar to stop resonating and sound burst to decay in environment
-	MOV delay, 3000000
-RESET_DELAY:
-	SUB delay, delay, 1
-	QBNE RESET_DELAY, delay, 0
-	
-	// Jump back to triggering the sonar
+
+PUSHED:
+
+	// Wait until a period has passed since the trigger, which also lets the
+	// sonar stop resonating and the sound burst decay in the environment
+PACE:
+	LBCO r2, C26, IEP_TMR_CNT, 4
+	SUB r2, r2, timeLo
+	QBGT PACE, r2, period
+
+	// Continue with the next sensor
+	ADD sensor, sensor, 4
+	QBNE TRIGGER, sensor, sensorEnd
+
+	// Jump back to triggering the first sonar
+	MOV sensor, 0
 	JMP TRIGGER
-	
+
 	HALT
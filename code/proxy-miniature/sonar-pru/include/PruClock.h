@@ -0,0 +1,64 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PROXY_MINIATURE_PRUCLOCK_H
+#define PROXY_MINIATURE_PRUCLOCK_H
+
+#include <array>
+#include <cstdint>
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+/**
+ * Maps the PRU time, the IEP timer extended to 64 bits, to host time. The
+ * host reads the timer between two readings of its own clock, and the
+ * offset is taken from the reading with the shortest such window among the
+ * latest WINDOW_SIZE readings, so that preemption does not disturb it while
+ * clock drift is still followed.
+ */
+class PruClock {
+ public:
+  static uint32_t const WINDOW_SIZE = 32;
+
+  PruClock();
+  PruClock(PruClock const &) = delete;
+  PruClock &operator=(PruClock const &) = delete;
+  virtual ~PruClock();
+
+  void Update(int64_t const, uint32_t const, int64_t const);
+  bool IsValid() const;
+  uint64_t GetPruNs() const;
+  int64_t GetOffsetNs() const;
+  int64_t ToHostNs(uint64_t const) const;
+
+ private:
+  uint64_t m_pruNs;
+  std::array<int64_t, WINDOW_SIZE> m_offsets;
+  std::array<int64_t, WINDOW_SIZE> m_windows;
+  uint32_t m_count;
+  uint32_t m_next;
+  int64_t m_offset;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,51 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PROXY_MINIATURE_PRUDRIVER_H
+#define PROXY_MINIATURE_PRUDRIVER_H
+
+#include <cstdint>
+#include <string>
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+/**
+ * The parts of prussdrv used by the sonar, so that the ingest path can run
+ * against a simulated PRU.
+ */
+class PruDriver {
+ public:
+  virtual ~PruDriver() {}
+
+  virtual bool Open() = 0;
+  virtual void Close() = 0;
+  virtual volatile uint32_t *GetDataRam() = 0;
+  virtual volatile uint32_t *GetIep() = 0;
+  virtual int32_t GetEventFd() = 0;
+  virtual void ClearEvent() = 0;
+  virtual bool Start(std::string const &) = 0;
+  virtual void Stop() = 0;
+};
+
+}
+}
+}
+
+#endif
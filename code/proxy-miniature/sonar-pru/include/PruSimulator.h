@@ -0,0 +1,90 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PROXY_MINIATURE_PRUSIMULATOR_H
+#define PROXY_MINIATURE_PRUSIMULATOR_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include "PruDriver.h"
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+/**
+ * A PRU in user space, for running the sonar ingest path without hardware.
+ * The data ram and the IEP registers are an anonymous mapping, the event is
+ * an eventfd, and a producer thread does what firmware/hcsr04.p does: it
+ * triggers the sensors round-robin at the configured period and pushes a
+ * sample into the ring for each. The IEP counter starts from zero when the
+ * firmware is started, and is only written by the producer, at least every
+ * 50 us, so host times derived from it are that much coarser than on the
+ * hardware.
+ */
+class PruSimulator : public PruDriver {
+ public:
+  typedef std::function<uint32_t(uint32_t, uint64_t)> EchoFunction;
+
+  static uint32_t const DATA_RAM_SIZE = 8192;
+  static uint32_t const IEP_SIZE = 4096;
+
+  PruSimulator();
+  PruSimulator(PruSimulator const &) = delete;
+  PruSimulator &operator=(PruSimulator const &) = delete;
+  virtual ~PruSimulator();
+
+  virtual bool Open();
+  virtual void Close();
+  virtual volatile uint32_t *GetDataRam();
+  virtual volatile uint32_t *GetIep();
+  virtual int32_t GetEventFd();
+  virtual void ClearEvent();
+  virtual bool Start(std::string const &);
+  virtual void Stop();
+
+  void SetPeriodNs(uint32_t const);
+  void SetEcho(EchoFunction);
+  uint64_t GetSampleCount() const;
+
+ private:
+  void Produce();
+  uint64_t UpdateIep();
+
+  void *m_memory;
+  volatile uint32_t *m_dataRam;
+  volatile uint32_t *m_iep;
+  int32_t m_eventFd;
+  uint32_t m_periodNs;
+  EchoFunction m_echo;
+  std::chrono::steady_clock::time_point m_start;
+  std::atomic<bool> m_running;
+  std::atomic<uint64_t> m_sampleCount;
+  std::thread m_producer;
+};
+
+}
+}
+}
+
+#endif
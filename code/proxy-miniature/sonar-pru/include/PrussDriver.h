@@ -0,0 +1,61 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PROXY_MINIATURE_PRUSSDRIVER_H
+#define PROXY_MINIATURE_PRUSSDRIVER_H
+
+#include <cstdint>
+#include <string>
+
+#include "PruDriver.h"
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+/**
+ * The PRU of the BeagleBone Black, through prussdrv and /dev/uio*.
+ */
+class PrussDriver : public PruDriver {
+ public:
+  PrussDriver(uint16_t const);
+  PrussDriver(PrussDriver const &) = delete;
+  PrussDriver &operator=(PrussDriver const &) = delete;
+  virtual ~PrussDriver();
+
+  virtual bool Open();
+  virtual void Close();
+  virtual volatile uint32_t *GetDataRam();
+  virtual volatile uint32_t *GetIep();
+  virtual int32_t GetEventFd();
+  virtual void ClearEvent();
+  virtual bool Start(std::string const &);
+  virtual void Stop();
+
+ private:
+  uint16_t m_pruIndex;
+  bool m_isOpen;
+  volatile uint32_t *m_dataRam;
+  volatile uint32_t *m_iep;
+};
+
+}
+}
+}
+
+#endif
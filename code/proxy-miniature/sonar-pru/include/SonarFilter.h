@@ -0,0 +1,69 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PROXY_MINIATURE_SONARFILTER_H
+#define PROXY_MINIATURE_SONARFILTER_H
+
+#include <array>
+#include <cstdint>
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+/**
+ * Filter for one sonar. The output is the median of the valid distances in
+ * a sliding window, where timeouts and distances outside the range of the
+ * sensor are invalid. Without any valid distance in the window the output
+ * is the maximum range, as nothing was seen. The confidence is the share of
+ * the window that is valid and agrees with the median within a tolerance,
+ * so it is low while spikes or timeouts are common.
+ */
+class SonarFilter {
+ public:
+  static uint32_t const MAX_MEDIAN_SIZE = 15;
+
+  SonarFilter(uint32_t const, float const, float const, float const);
+  virtual ~SonarFilter();
+
+  void Add(float const);
+  float GetDistance() const;
+  float GetConfidence() const;
+  bool IsTimedOut() const;
+  void Reset();
+
+ private:
+  void Update();
+
+  uint32_t m_medianSize;
+  float m_minRange;
+  float m_maxRange;
+  float m_tolerance;
+  std::array<float, MAX_MEDIAN_SIZE> m_window;
+  uint32_t m_windowIndex;
+  uint32_t m_windowCount;
+  float m_distance;
+  float m_confidence;
+  bool m_timedOut;
+};
+
+}
+}
+}
+
+#endif
@@ -22,15 +22,24 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <opendavinci/odcore/base/module/TimeTriggeredConferenceClientModule.h>
 
+#include "PruDriver.h"
+#include "SonarFilter.h"
+#include "SonarReceiver.h"
+#include "SonarRing.h"
+
 namespace opendlv {
 namespace proxy {
 namespace miniature {
 
 /**
- * Interface to a sensor sensor using the BeagleBone Black PRU.
+ * Interface to a sensor sensor using the BeagleBone Black PRU. The firmware
+ * paces the measurements itself, and the receiver publishes the samples
+ * from its event thread as soon as the PRU signals them, so the module
+ * frequency only affects how fast problems are reported.
  */
 class SonarPru : public odcore::base::module::TimeTriggeredConferenceClientModule {
    public:
@@ -43,11 +52,15 @@ class SonarPru : public odcore::base::module::TimeTriggeredConferenceClientModul
     virtual void setUp();
     virtual void tearDown();
     virtual odcore::data::dmcp::ModuleExitCodeMessage::ModuleExitCode body();
+    void publishSample(SonarSample const &, int64_t const);
    
     bool m_debug;
     bool m_initialized;
     uint16_t m_pruIndex;
-    unsigned int *m_pruData;
+    std::unique_ptr<PruDriver> m_driver;
+    std::unique_ptr<SonarReceiver> m_receiver;
+    std::vector<SonarFilter> m_filters;
+    uint32_t m_dropped;
 };
 
 } 
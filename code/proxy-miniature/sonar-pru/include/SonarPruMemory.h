@@ -0,0 +1,79 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PROXY_MINIATURE_SONARPRUMEMORY_H
+#define PROXY_MINIATURE_SONARPRUMEMORY_H
+
+#include <cstdint>
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+/**
+ * Layout of the PRU0 data ram, as 32 bit word indices. It must match the
+ * offsets in firmware/hcsr04.p.
+ */
+namespace sonarprumemory {
+
+// Number of sensors, written by the host before the firmware starts.
+uint32_t const SENSOR_COUNT = 0;
+
+// Nanoseconds from one trigger to the next, written by the host before the
+// firmware starts. Zero gives the firmware default of 60 ms.
+uint32_t const PERIOD = 1;
+
+// One word per sensor, gpio1 trigger bit in byte 0 and echo bit in byte 1.
+uint32_t const SENSOR_CONFIG = 4;
+
+uint32_t const MAX_SENSORS = 8;
+
+// Index of the next ring entry to write, only written by the PRU.
+uint32_t const RING_HEAD = 16;
+
+// Index of the next ring entry to read, only written by the host.
+uint32_t const RING_TAIL = 17;
+
+// Number of samples the PRU dropped because the ring was full.
+uint32_t const RING_DROPPED = 18;
+
+// Ring entries of RING_ENTRY_WORDS words: sensor, echo width in PRU cycles
+// (zero if no echo was measured) and the low and high word of the IEP time in
+// nanoseconds when the sensor was triggered. One entry is always left empty, so at
+// most RING_SIZE - 1 samples are buffered.
+uint32_t const RING = 32;
+uint32_t const RING_SIZE = 64;
+uint32_t const RING_ENTRY_WORDS = 4;
+
+// The PRU runs at 200 MHz.
+uint32_t const CYCLE_NS = 5;
+
+// Word indices of the IEP timer registers, and the configuration that
+// makes it count nanoseconds by adding 5 every cycle. The counter is
+// cleared by writing ones.
+uint32_t const IEP_TMR_GLB_CFG = 0;
+uint32_t const IEP_TMR_CNT = 3;
+uint32_t const IEP_CNT_ENABLE_INC_5 = 0x51;
+
+}
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,79 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PROXY_MINIATURE_SONARRECEIVER_H
+#define PROXY_MINIATURE_SONARRECEIVER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "PruClock.h"
+#include "PruDriver.h"
+#include "SonarPruMemory.h"
+#include "SonarRing.h"
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+/**
+ * Starts the sonar firmware and hands over every sample it produces, with
+ * its capture time in host nanoseconds, from an event thread. The thread
+ * waits for the PRU event with a timeout, so that it stops even if the PRU
+ * does not signal, and drains the ring on every wake up, which also picks
+ * up samples whose events were merged.
+ */
+class SonarReceiver {
+ public:
+  typedef std::function<void(SonarSample const &, int64_t)> SampleCallback;
+
+  SonarReceiver(PruDriver &, SampleCallback);
+  SonarReceiver(SonarReceiver const &) = delete;
+  SonarReceiver &operator=(SonarReceiver const &) = delete;
+  virtual ~SonarReceiver();
+
+  bool Start(std::string const &, std::vector<uint32_t> const &, 
+      uint32_t const);
+  void Stop();
+  bool IsRunning() const;
+  uint32_t GetDropped() const;
+
+ private:
+  void Run();
+  void UpdateClock();
+  void Drain();
+
+  PruDriver &m_driver;
+  SampleCallback m_callback;
+  SonarRing m_ring;
+  PruClock m_clock;
+  std::array<SonarSample, sonarprumemory::RING_SIZE> m_samples;
+  std::atomic<bool> m_running;
+  std::thread m_thread;
+};
+
+}
+}
+}
+
+#endif
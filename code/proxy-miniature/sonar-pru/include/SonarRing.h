@@ -0,0 +1,60 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PROXY_MINIATURE_SONARRING_H
+#define PROXY_MINIATURE_SONARRING_H
+
+#include <cstdint>
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+struct SonarSample {
+  uint32_t sensorId;
+  uint32_t echoCycles;
+  uint64_t triggerTimeNs;
+};
+
+/**
+ * Consumer side of the single producer, single consumer ring that the PRU
+ * firmware writes sonar samples into. The PRU only writes the entries and
+ * the head, the host only writes the tail, so no locking is needed.
+ */
+class SonarRing {
+ public:
+  SonarRing();
+  SonarRing(SonarRing const &) = delete;
+  SonarRing &operator=(SonarRing const &) = delete;
+  virtual ~SonarRing();
+
+  void Attach(volatile uint32_t *);
+  void Reset();
+  uint32_t Drain(SonarSample *, uint32_t const);
+  uint32_t GetDropped() const;
+
+ private:
+  volatile uint32_t *m_data;
+  uint32_t m_tail;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,94 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "PruClock.h"
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+uint32_t const PruClock::WINDOW_SIZE;
+
+PruClock::PruClock()
+    : m_pruNs(0)
+    , m_offsets()
+    , m_windows()
+    , m_count(0)
+    , m_next(0)
+    , m_offset(0)
+{
+}
+
+PruClock::~PruClock()
+{
+}
+
+/**
+ * Adds a reading of the 32 bit IEP counter, taken between the two host
+ * times in nanoseconds. It must be called at least once per counter wrap,
+ * every 4.3 s, to keep the same 64 bit time as the firmware.
+ */
+void PruClock::Update(int64_t const a_hostBeforeNs, uint32_t const a_count, 
+    int64_t const a_hostAfterNs)
+{
+  uint64_t high = m_pruNs & (static_cast<uint64_t>(0xffffffff) << 32);
+  if (a_count < static_cast<uint32_t>(m_pruNs)) {
+    high += static_cast<uint64_t>(1) << 32;
+  }
+  m_pruNs = high | a_count;
+
+  m_offsets[m_next] = a_hostBeforeNs + (a_hostAfterNs - a_hostBeforeNs) / 2 
+      - static_cast<int64_t>(m_pruNs);
+  m_windows[m_next] = a_hostAfterNs - a_hostBeforeNs;
+  m_next = (m_next + 1) % WINDOW_SIZE;
+  if (m_count < WINDOW_SIZE) {
+    m_count++;
+  }
+
+  uint32_t best = 0;
+  for (uint32_t i = 1; i < m_count; i++) {
+    if (m_windows[i] < m_windows[best]) {
+      best = i;
+    }
+  }
+  m_offset = m_offsets[best];
+}
+
+bool PruClock::IsValid() const
+{
+  return (m_count > 0);
+}
+
+uint64_t PruClock::GetPruNs() const
+{
+  return m_pruNs;
+}
+
+int64_t PruClock::GetOffsetNs() const
+{
+  return m_offset;
+}
+
+int64_t PruClock::ToHostNs(uint64_t const a_pruNs) const
+{
+  return static_cast<int64_t>(a_pruNs) + m_offset;
+}
+
+}
+}
+}
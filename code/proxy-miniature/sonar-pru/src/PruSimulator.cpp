@@ -0,0 +1,223 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "PruSimulator.h"
+#include "SonarPruMemory.h"
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+uint32_t const PruSimulator::DATA_RAM_SIZE;
+uint32_t const PruSimulator::IEP_SIZE;
+
+PruSimulator::PruSimulator()
+    : m_memory(MAP_FAILED)
+    , m_dataRam(nullptr)
+    , m_iep(nullptr)
+    , m_eventFd(-1)
+    , m_periodNs(0)
+    , m_echo()
+    , m_start()
+    , m_running(false)
+    , m_sampleCount(0)
+    , m_producer()
+{
+}
+
+PruSimulator::~PruSimulator()
+{
+  Stop();
+  Close();
+}
+
+bool PruSimulator::Open()
+{
+  m_memory = mmap(nullptr, DATA_RAM_SIZE + IEP_SIZE, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  m_eventFd = eventfd(0, EFD_NONBLOCK);
+  if (m_memory == MAP_FAILED || m_eventFd < 0) {
+    Close();
+    return false;
+  }
+  m_dataRam = static_cast<volatile uint32_t *>(m_memory);
+  m_iep = m_dataRam + DATA_RAM_SIZE / sizeof(uint32_t);
+  return true;
+}
+
+void PruSimulator::Close()
+{
+  if (m_memory != MAP_FAILED) {
+    munmap(m_memory, DATA_RAM_SIZE + IEP_SIZE);
+    m_memory = MAP_FAILED;
+  }
+  if (m_eventFd >= 0) {
+    close(m_eventFd);
+    m_eventFd = -1;
+  }
+  m_dataRam = nullptr;
+  m_iep = nullptr;
+}
+
+volatile uint32_t *PruSimulator::GetDataRam()
+{
+  return m_dataRam;
+}
+
+volatile uint32_t *PruSimulator::GetIep()
+{
+  return m_iep;
+}
+
+int32_t PruSimulator::GetEventFd()
+{
+  return m_eventFd;
+}
+
+void PruSimulator::ClearEvent()
+{
+  uint64_t count;
+  if (read(m_eventFd, &count, sizeof(count)) < 0) {
+    return;
+  }
+}
+
+bool PruSimulator::Start(std::string const &)
+{
+  if (m_dataRam == nullptr || m_running) {
+    return false;
+  }
+  m_start = std::chrono::steady_clock::now();
+  m_iep[sonarprumemory::IEP_TMR_CNT] = 0;
+  m_running = true;
+  m_producer = std::thread(&PruSimulator::Produce, this);
+  return true;
+}
+
+void PruSimulator::Stop()
+{
+  m_running = false;
+  if (m_producer.joinable()) {
+    m_producer.join();
+  }
+}
+
+/**
+ * Sets the period between triggers, overriding the one in data ram. It is
+ * not limited like the hardware, so that the ring can be stressed.
+ */
+void PruSimulator::SetPeriodNs(uint32_t const a_periodNs)
+{
+  m_periodNs = a_periodNs;
+}
+
+/**
+ * Sets the echo width in cycles, given the sensor and the number of the
+ * sample. Without it every echo is 1 ms.
+ */
+void PruSimulator::SetEcho(EchoFunction a_echo)
+{
+  m_echo = a_echo;
+}
+
+uint64_t PruSimulator::GetSampleCount() const
+{
+  return m_sampleCount;
+}
+
+/**
+ * Writes the 32 bit IEP counter, and returns the same time in 64 bits.
+ */
+uint64_t PruSimulator::UpdateIep()
+{
+  uint64_t const timeNs = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - m_start).count());
+  m_iep[sonarprumemory::IEP_TMR_CNT] = static_cast<uint32_t>(timeNs);
+  return timeNs;
+}
+
+void PruSimulator::Produce()
+{
+  uint32_t sensorCount = std::min(
+      static_cast<uint32_t>(m_dataRam[sonarprumemory::SENSOR_COUNT]),
+      sonarprumemory::MAX_SENSORS);
+  if (sensorCount == 0) {
+    sensorCount = 1;
+  }
+  uint32_t periodNs = m_periodNs;
+  if (periodNs == 0) {
+    periodNs = m_dataRam[sonarprumemory::PERIOD];
+  }
+  if (periodNs == 0) {
+    periodNs = 60000000;
+  }
+
+  uint32_t head = m_dataRam[sonarprumemory::RING_HEAD];
+  uint32_t sensor = 0;
+  uint64_t sample = 0;
+  while (m_running) {
+    uint64_t const triggerNs = UpdateIep();
+    uint32_t const echoCycles = m_echo ? m_echo(sensor, sample) : 200000;
+
+    uint32_t const next = (head + 1) % sonarprumemory::RING_SIZE;
+    if (next == m_dataRam[sonarprumemory::RING_TAIL]) {
+      m_dataRam[sonarprumemory::RING_DROPPED] = 
+          m_dataRam[sonarprumemory::RING_DROPPED] + 1;
+    } else {
+      volatile uint32_t *entry = m_dataRam + sonarprumemory::RING 
+          + head * sonarprumemory::RING_ENTRY_WORDS;
+      entry[0] = sensor;
+      entry[1] = echoCycles;
+      entry[2] = static_cast<uint32_t>(triggerNs);
+      entry[3] = static_cast<uint32_t>(triggerNs >> 32);
+      std::atomic_thread_fence(std::memory_order_release);
+      head = next;
+      m_dataRam[sonarprumemory::RING_HEAD] = head;
+
+      uint64_t const one = 1;
+      if (write(m_eventFd, &one, sizeof(one)) < 0) {
+        m_running = false;
+      }
+    }
+    m_sampleCount++;
+    sensor = (sensor + 1) % sensorCount;
+    sample++;
+
+    // The IEP counter is kept fresh while waiting, as the host reads it.
+    uint64_t const nextTriggerNs = triggerNs + periodNs;
+    while (m_running && UpdateIep() < nextTriggerNs) {
+      std::this_thread::sleep_for(std::chrono::microseconds(std::min(
+            static_cast<uint64_t>(50), (nextTriggerNs - UpdateIep()) / 1000)));
+    }
+  }
+}
+
+}
+}
+}
@@ -0,0 +1,112 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <pruss/prussdrv.h>
+#include <pruss/pruss_intc_mapping.h>
+
+#include "PrussDriver.h"
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+PrussDriver::PrussDriver(uint16_t const a_pruIndex)
+    : m_pruIndex(a_pruIndex)
+    , m_isOpen(false)
+    , m_dataRam(nullptr)
+    , m_iep(nullptr)
+{
+}
+
+PrussDriver::~PrussDriver()
+{
+  Close();
+}
+
+bool PrussDriver::Open()
+{
+  tpruss_intc_initdata prussIntcInitData = PRUSS_INTC_INITDATA;
+  prussdrv_init();
+
+  if (prussdrv_open(PRU_EVTOUT_0)) {
+    return false;
+  }
+  m_isOpen = true;
+
+  prussdrv_pruintc_init(&prussIntcInitData);
+
+  void *pruDataMem;
+  void *pruIepMem;
+  if (prussdrv_map_prumem(PRUSS0_PRU0_DATARAM, &pruDataMem) 
+      || prussdrv_map_peripheral_io(PRUSS0_IEP, &pruIepMem)) {
+    Close();
+    return false;
+  }
+  m_dataRam = static_cast<volatile uint32_t *>(pruDataMem);
+  m_iep = static_cast<volatile uint32_t *>(pruIepMem);
+  return true;
+}
+
+void PrussDriver::Close()
+{
+  if (m_isOpen) {
+    prussdrv_exit();
+    m_isOpen = false;
+    m_dataRam = nullptr;
+    m_iep = nullptr;
+  }
+}
+
+volatile uint32_t *PrussDriver::GetDataRam()
+{
+  return m_dataRam;
+}
+
+volatile uint32_t *PrussDriver::GetIep()
+{
+  return m_iep;
+}
+
+int32_t PrussDriver::GetEventFd()
+{
+  return prussdrv_pru_event_fd(PRU_EVTOUT_0);
+}
+
+/**
+ * Reads the event count, which is known to be ready, and clears the event
+ * so that the host interrupt is enabled again.
+ */
+void PrussDriver::ClearEvent()
+{
+  prussdrv_pru_wait_event(PRU_EVTOUT_0);
+  prussdrv_pru_clear_event(PRU_EVTOUT_0, PRU0_ARM_INTERRUPT);
+}
+
+bool PrussDriver::Start(std::string const &a_firmwarePath)
+{
+  return (prussdrv_exec_program(m_pruIndex, a_firmwarePath.c_str()) == 0);
+}
+
+void PrussDriver::Stop()
+{
+  prussdrv_pru_disable(m_pruIndex);
+}
+
+}
+}
+}
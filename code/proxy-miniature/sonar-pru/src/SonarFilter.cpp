@@ -0,0 +1,136 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "SonarFilter.h"
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+uint32_t const SonarFilter::MAX_MEDIAN_SIZE;
+
+SonarFilter::SonarFilter(uint32_t const a_medianSize, float const a_minRange,
+    float const a_maxRange, float const a_tolerance)
+    : m_medianSize(std::min(std::max(a_medianSize, 1u), MAX_MEDIAN_SIZE))
+    , m_minRange(a_minRange)
+    , m_maxRange(a_maxRange)
+    , m_tolerance(a_tolerance)
+    , m_window()
+    , m_windowIndex(0)
+    , m_windowCount(0)
+    , m_distance(a_maxRange)
+    , m_confidence(0.0f)
+    , m_timedOut(false)
+{
+}
+
+SonarFilter::~SonarFilter()
+{
+}
+
+/**
+ * Adds a distance, or NaN if the echo timed out.
+ */
+void SonarFilter::Add(float const a_distance)
+{
+  bool const isValid = (a_distance >= m_minRange && a_distance <= m_maxRange);
+  m_timedOut = std::isnan(a_distance);
+
+  m_window[m_windowIndex] = isValid ? a_distance : std::nanf("");
+  m_windowIndex = (m_windowIndex + 1) % m_medianSize;
+  m_windowCount = std::min(m_windowCount + 1, m_medianSize);
+  Update();
+}
+
+/**
+ * Returns the filtered distance, which is the maximum range before any
+ * valid distance.
+ */
+float SonarFilter::GetDistance() const
+{
+  return m_distance;
+}
+
+/**
+ * Returns the confidence between zero and one. It builds up over the
+ * first window.
+ */
+float SonarFilter::GetConfidence() const
+{
+  return m_confidence;
+}
+
+/**
+ * Returns true if the latest echo timed out.
+ */
+bool SonarFilter::IsTimedOut() const
+{
+  return m_timedOut;
+}
+
+void SonarFilter::Reset()
+{
+  m_windowIndex = 0;
+  m_windowCount = 0;
+  m_distance = m_maxRange;
+  m_confidence = 0.0f;
+  m_timedOut = false;
+}
+
+void SonarFilter::Update()
+{
+  // Insertion sort of the valid distances, which is cheap for the short
+  // windows used.
+  std::array<float, MAX_MEDIAN_SIZE> sorted;
+  uint32_t validCount = 0;
+  for (uint32_t i = 0; i < m_windowCount; i++) {
+    float const value = m_window[i];
+    if (std::isnan(value)) {
+      continue;
+    }
+    uint32_t j = validCount;
+    for (; j > 0 && sorted[j - 1] > value; j--) {
+      sorted[j] = sorted[j - 1];
+    }
+    sorted[j] = value;
+    validCount++;
+  }
+
+  if (validCount == 0) {
+    m_distance = m_maxRange;
+    m_confidence = 0.0f;
+    return;
+  }
+
+  m_distance = sorted[(validCount - 1) / 2];
+  uint32_t agreeing = 0;
+  for (uint32_t i = 0; i < validCount; i++) {
+    if (std::fabs(sorted[i] - m_distance) <= m_tolerance) {
+      agreeing++;
+    }
+  }
+  m_confidence = static_cast<float>(agreeing) / m_medianSize;
+}
+
+}
+}
+}
@@ -18,19 +18,18 @@
 
 #include <cmath>
 #include <iostream>
-#include <fstream>
+#include <memory>
 #include <string>
 #include <vector>
 
-#include <pruss/prussdrv.h>
-#include <pruss/pruss_intc_mapping.h>
-
 #include <opendavinci/odcore/base/KeyValueConfiguration.h>
 #include <opendavinci/odcore/data/Container.h>
+#include <opendavinci/odcore/data/TimeStamp.h>
 
 #include <odvdminiature/GeneratedHeaders_ODVDMiniature.h>
 #include <opendavinci/odcore/strings/StringToolbox.h>
 
+#include "PrussDriver.h"
 #include "SonarPru.h"
 
 namespace opendlv {
@@ -42,7 +41,10 @@ SonarPru::SonarPru(const int &argc, char **argv)
     , m_debug(false)
     , m_initialized(false)
     , m_pruIndex()
-    , m_pruData()
+    , m_driver()
+    , m_receiver()
+    , m_filters()
+    , m_dropped(0)
 {
 }
 
@@ -60,40 +62,115 @@ void SonarPru::setUp()
   m_pruIndex = kv.getValue<uint16_t>("proxy-miniature-sonar-pru.pruIndex");
   std::string firmwarePath = kv.getValue<std::string>("proxy-miniature-sonar-pru.firmwarePath");
 
-  std::cout << "Initializing PRU" << m_pruIndex << std::endl;
+  // The sensors are given as gpio1 bit numbers of their trigger and echo 
+  // pins, and are numbered in the given order. Without any, a single sensor
+  // with trigger on gpio1[12] and echo on gpio1[13] is used.
+  std::vector<std::string> triggerBits = {"12"};
+  std::vector<std::string> echoBits = {"13"};
+  bool valueFound;
+  std::string const triggerBitsString = kv.getOptionalValue<std::string>(
+      "proxy-miniature-sonar-pru.triggerBits", valueFound);
+  if (valueFound) {
+    triggerBits = odcore::strings::StringToolbox::split(triggerBitsString, ',');
+    echoBits = odcore::strings::StringToolbox::split(
+        kv.getValue<std::string>("proxy-miniature-sonar-pru.echoBits"), ',');
+  }
+  if (triggerBits.size() != echoBits.size() || triggerBits.empty()
+      || triggerBits.size() > sonarprumemory::MAX_SENSORS) {
+    std::cerr << "[" << getName() << "] Number of trigger and echo bits do "
+        << "not match, or are more than " << sonarprumemory::MAX_SENSORS 
+        << "." << std::endl;
+    m_initialized = false;
+    return;
+  }
+  std::vector<uint32_t> sensorConfigs;
+  for (uint32_t i = 0; i < triggerBits.size(); i++) {
+    uint32_t const triggerBit = std::stoi(triggerBits[i]);
+    uint32_t const echoBit = std::stoi(echoBits[i]);
+    sensorConfigs.push_back(triggerBit | (echoBit << 8));
+  }
 
-  tpruss_intc_initdata prussIntcInitData = PRUSS_INTC_INITDATA;
-  prussdrv_init();
+  // Measurements per second, over all sensors, paced by the firmware. The 
+  // IEP timer must be read at least once per wrap, so it is at least 1 Hz.
+  uint32_t periodNs = 0;
+  double const measurementFrequency = kv.getOptionalValue<double>(
+      "proxy-miniature-sonar-pru.measurementFrequency", valueFound);
+  if (valueFound) {
+    if (!(measurementFrequency >= 1.0 && measurementFrequency <= 50.0)) {
+      std::cerr << "[" << getName() << "] The measurement frequency must be "
+          << "between 1 and 50 Hz." << std::endl;
+      m_initialized = false;
+      return;
+    }
+    periodNs = static_cast<uint32_t>(1.0e9 / measurementFrequency);
+  }
+
+  // Each sensor has a filter. Distances are in cm, the HC-SR04 measures 
+  // from 2 to 400 cm.
+  uint32_t medianSize = kv.getOptionalValue<uint32_t>(
+      "proxy-miniature-sonar-pru.medianSize", valueFound);
+  if (!valueFound) {
+    medianSize = 1;
+  }
+  float minRange = kv.getOptionalValue<float>(
+      "proxy-miniature-sonar-pru.minRange", valueFound);
+  if (!valueFound) {
+    minRange = 2.0f;
+  }
+  float maxRange = kv.getOptionalValue<float>(
+      "proxy-miniature-sonar-pru.maxRange", valueFound);
+  if (!valueFound) {
+    maxRange = 400.0f;
+  }
+  float tolerance = kv.getOptionalValue<float>(
+      "proxy-miniature-sonar-pru.tolerance", valueFound);
+  if (!valueFound) {
+    tolerance = 5.0f;
+  }
+  m_filters.clear();
+  for (uint32_t i = 0; i < sensorConfigs.size(); i++) {
+    m_filters.push_back(SonarFilter(medianSize, minRange, maxRange, 
+          tolerance));
+  }
+
+  std::cout << "Initializing PRU" << m_pruIndex << std::endl;
 
-  if (prussdrv_open(PRU_EVTOUT_0)) {
+  m_driver.reset(new PrussDriver(m_pruIndex));
+  if (!m_driver->Open()) {
     std::cerr << "PRU" << m_pruIndex << " open failed" << std::endl;
     m_initialized = false;
     return;
   }
 
-  prussdrv_pruintc_init(&prussIntcInitData);
-
-  void *pruDataMem;
-  prussdrv_map_prumem(PRUSS0_PRU0_DATARAM, &pruDataMem);
-
-  m_pruData = (unsigned int *) pruDataMem;
+  m_receiver.reset(new SonarReceiver(*m_driver, 
+        [this](SonarSample const &a_sample, int64_t a_sampleTimeNs) 
+        {
+          publishSample(a_sample, a_sampleTimeNs);
+        }));
 
   std::cout << "Loading PRU binary " << firmwarePath << std::endl;
-  prussdrv_exec_program(m_pruIndex, firmwarePath.c_str());
+  if (!m_receiver->Start(firmwarePath, sensorConfigs, periodNs)) {
+    std::cerr << "[" << getName() << "] Could not start the PRU." 
+        << std::endl;
+    m_driver->Close();
+    m_initialized = false;
+    return;
+  }
+  m_dropped = 0;
 }
 
 void SonarPru::tearDown() 
 {
   if (m_initialized) {
-    prussdrv_pru_disable(m_pruIndex);
-    prussdrv_exit();
+    m_receiver->Stop();
+    m_driver->Close();
     std::cout << "PRU" << m_pruIndex << " was disabled." << std::endl;
   }
 }
 
-
 odcore::data::dmcp::ModuleExitCodeMessage::ModuleExitCode SonarPru::body()
 {
+  // The samples are published by the event thread of the receiver.
   while (getModuleStateAndWaitForRemainingTimeInTimeslice() == 
         odcore::data::dmcp::ModuleStateMessage::RUNNING) {
 
@@ -101,24 +178,63 @@ odcore::data::dmcp::ModuleExitCodeMessage::ModuleExitCode SonarPru::body()
       continue;
     }
 
-    prussdrv_pru_wait_event (PRU_EVTOUT_0);
-    prussdrv_pru_clear_event(PRU_EVTOUT_0, PRU0_ARM_INTERRUPT);
-
-    // Roundtrip 1 cm: 58.44 us
-    double distance = static_cast<double>(m_pruData[0]) / 58.44;
-  
-    opendlv::proxy::ProximityReading message(distance);
-    odcore::data::Container c(message);
-    getConference().send(c);
+    if (!m_receiver->IsRunning()) {
+      std::cerr << "[" << getName() << "] Could not wait for the PRU event." 
+          << std::endl;
+      return odcore::data::dmcp::ModuleExitCodeMessage::SERIOUS_ERROR;
+    }
 
-    if (m_debug) {
-      std::cout << "Distance " << distance << std::endl;
+    uint32_t const dropped = m_receiver->GetDropped();
+    if (dropped != m_dropped) {
+      std::cerr << "[" << getName() << "] Ring full, " << (dropped - m_dropped) 
+          << " samples dropped." << std::endl;
+      m_dropped = dropped;
     }
   }
 
   return odcore::data::dmcp::ModuleExitCodeMessage::OKAY;
 }
 
+/**
+ * Filters and publishes a sample, called from the event thread of the
+ * receiver, which is the only user of the filters.
+ */
+void SonarPru::publishSample(SonarSample const &a_sample, 
+    int64_t const a_sampleTimeNs)
+{
+  if (a_sample.sensorId >= m_filters.size()) {
+    return;
+  }
+
+  // Roundtrip 1 cm: 58.44 us, and zero cycles means that the echo timed out.
+  double const roundtripUs = static_cast<double>(a_sample.echoCycles) 
+      * sonarprumemory::CYCLE_NS / 1000.0;
+  float const rawDistance = (a_sample.echoCycles > 0) 
+      ? static_cast<float>(roundtripUs / 58.44) : std::nanf("");
+
+  SonarFilter &filter = m_filters[a_sample.sensorId];
+  filter.Add(rawDistance);
+  double const distance = filter.GetDistance();
+  float const confidence = filter.GetConfidence();
+
+  // The sample is taken when the sensor was triggered.
+  int64_t const sampleUs = a_sampleTimeNs / 1000;
+
+  opendlv::proxy::ProximityReading message(distance, 
+      static_cast<uint16_t>(a_sample.sensorId), confidence);
+  odcore::data::Container c(message);
+  c.setSampleTimeStamp(odcore::data::TimeStamp(
+        static_cast<int32_t>(sampleUs / 1000000), 
+        static_cast<int32_t>(sampleUs % 1000000)));
+  getConference().send(c);
+
+  if (m_debug) {
+    std::cout << "Sensor " << a_sample.sensorId << " raw " << rawDistance 
+        << (filter.IsTimedOut() ? " (timeout)" : "") << " distance " 
+        << distance << " confidence " << confidence << std::endl;
+  }
+}
+
 }
 }
 }
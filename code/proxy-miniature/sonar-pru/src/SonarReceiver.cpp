@@ -0,0 +1,162 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <poll.h>
+
+#include <cerrno>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "SonarReceiver.h"
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+SonarReceiver::SonarReceiver(PruDriver &a_driver, 
+    SampleCallback a_callback)
+    : m_driver(a_driver)
+    , m_callback(a_callback)
+    , m_ring()
+    , m_clock()
+    , m_samples()
+    , m_running(false)
+    , m_thread()
+{
+}
+
+SonarReceiver::~SonarReceiver()
+{
+  Stop();
+}
+
+/**
+ * Writes the sensors, given as trigger bit | (echo bit << 8), and the
+ * period between triggers in nanoseconds (zero for the firmware default) to
+ * the data ram of an opened driver, and starts the firmware and the event 
+ * thread.
+ */
+bool SonarReceiver::Start(std::string const &a_firmwarePath, 
+    std::vector<uint32_t> const &a_sensorConfigs, uint32_t const a_periodNs)
+{
+  volatile uint32_t *data = m_driver.GetDataRam();
+  volatile uint32_t *iep = m_driver.GetIep();
+  if (m_running || data == nullptr || iep == nullptr
+      || a_sensorConfigs.size() > sonarprumemory::MAX_SENSORS) {
+    return false;
+  }
+
+  data[sonarprumemory::SENSOR_COUNT] = 
+      static_cast<uint32_t>(a_sensorConfigs.size());
+  data[sonarprumemory::PERIOD] = a_periodNs;
+  for (uint32_t i = 0; i < a_sensorConfigs.size(); i++) {
+    data[sonarprumemory::SENSOR_CONFIG + i] = a_sensorConfigs[i];
+  }
+
+  m_ring.Attach(data);
+  m_ring.Reset();
+
+  // The IEP timer is the PRU time of the samples. It is started from zero
+  // here, just before the firmware, so that the host and the firmware
+  // extend it to the same 64 bit time.
+  iep[sonarprumemory::IEP_TMR_GLB_CFG] = 0;
+  iep[sonarprumemory::IEP_TMR_CNT] = 0xffffffff;
+  iep[sonarprumemory::IEP_TMR_GLB_CFG] = sonarprumemory::IEP_CNT_ENABLE_INC_5;
+
+  if (!m_driver.Start(a_firmwarePath)) {
+    return false;
+  }
+
+  m_running = true;
+  m_thread = std::thread(&SonarReceiver::Run, this);
+  return true;
+}
+
+void SonarReceiver::Stop()
+{
+  if (m_thread.joinable()) {
+    m_running = false;
+    m_thread.join();
+    m_driver.Stop();
+  }
+}
+
+/**
+ * Returns false if the event thread stopped on an error.
+ */
+bool SonarReceiver::IsRunning() const
+{
+  return m_running;
+}
+
+uint32_t SonarReceiver::GetDropped() const
+{
+  return m_ring.GetDropped();
+}
+
+void SonarReceiver::Run()
+{
+  int32_t const timeoutMs = 100;
+
+  pollfd eventFd;
+  eventFd.fd = m_driver.GetEventFd();
+  eventFd.events = POLLIN;
+
+  while (m_running) {
+    eventFd.revents = 0;
+    int32_t const result = poll(&eventFd, 1, timeoutMs);
+    if (result < 0 && errno != EINTR) {
+      m_running = false;
+      return;
+    }
+    if (result > 0 && (eventFd.revents & POLLIN)) {
+      m_driver.ClearEvent();
+    }
+
+    UpdateClock();
+    Drain();
+  }
+}
+
+/**
+ * Reads the IEP timer between two readings of the host clock, to follow
+ * the offset between the PRU time and host time.
+ */
+void SonarReceiver::UpdateClock()
+{
+  int64_t const before = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+  uint32_t const count = m_driver.GetIep()[sonarprumemory::IEP_TMR_CNT];
+  int64_t const after = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+  m_clock.Update(before, count, after);
+}
+
+void SonarReceiver::Drain()
+{
+  uint32_t const count = m_ring.Drain(m_samples.data(), 
+      static_cast<uint32_t>(m_samples.size()));
+  for (uint32_t i = 0; i < count; i++) {
+    m_callback(m_samples[i], m_clock.ToHostNs(m_samples[i].triggerTimeNs));
+  }
+}
+
+}
+}
+}
@@ -0,0 +1,103 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <atomic>
+
+#include "SonarPruMemory.h"
+#include "SonarRing.h"
+
+namespace opendlv {
+namespace proxy {
+namespace miniature {
+
+SonarRing::SonarRing()
+    : m_data(nullptr)
+    , m_tail(0)
+{
+}
+
+SonarRing::~SonarRing()
+{
+}
+
+/**
+ * Attaches to the data ram. The ring must be reset before the firmware
+ * starts.
+ */
+void SonarRing::Attach(volatile uint32_t *a_data)
+{
+  m_data = a_data;
+}
+
+void SonarRing::Reset()
+{
+  m_tail = 0;
+  if (m_data != nullptr) {
+    m_data[sonarprumemory::RING_HEAD] = 0;
+    m_data[sonarprumemory::RING_TAIL] = 0;
+    m_data[sonarprumemory::RING_DROPPED] = 0;
+  }
+}
+
+/**
+ * Copies at most the given number of samples, oldest first, and hands their
+ * entries back to the PRU. Returns the number of samples copied.
+ */
+uint32_t SonarRing::Drain(SonarSample *a_samples, uint32_t const a_capacity)
+{
+  if (m_data == nullptr) {
+    return 0;
+  }
+
+  uint32_t const head = m_data[sonarprumemory::RING_HEAD];
+  if (head >= sonarprumemory::RING_SIZE) {
+    return 0;
+  }
+  // The entries up to head were written before head was published.
+  std::atomic_thread_fence(std::memory_order_acquire);
+
+  uint32_t count = 0;
+  while (m_tail != head && count < a_capacity) {
+    volatile uint32_t const *entry = m_data + sonarprumemory::RING
+        + m_tail * sonarprumemory::RING_ENTRY_WORDS;
+    SonarSample &sample = a_samples[count];
+    sample.sensorId = entry[0];
+    sample.echoCycles = entry[1];
+    sample.triggerTimeNs = static_cast<uint64_t>(entry[2])
+        | (static_cast<uint64_t>(entry[3]) << 32);
+    m_tail = (m_tail + 1) % sonarprumemory::RING_SIZE;
+    count++;
+  }
+
+  // The entries must be read before the PRU may overwrite them.
+  std::atomic_thread_fence(std::memory_order_release);
+  m_data[sonarprumemory::RING_TAIL] = m_tail;
+  return count;
+}
+
+uint32_t SonarRing::GetDropped() const
+{
+  if (m_data == nullptr) {
+    return 0;
+  }
+  return m_data[sonarprumemory::RING_DROPPED];
+}
+
+}
+}
+}
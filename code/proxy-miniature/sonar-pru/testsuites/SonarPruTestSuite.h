@@ -19,10 +19,27 @@
 #ifndef SONARPRU_TESTSUITE_H
 #define SONARPRU_TESTSUITE_H
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "cxxtest/TestSuite.h"
 
 // Include local header files.
+#include "../include/PruClock.h"
+#include "../include/PruSimulator.h"
+#include "../include/SonarFilter.h"
 #include "../include/SonarPru.h"
+#include "../include/SonarPruMemory.h"
+#include "../include/SonarReceiver.h"
+#include "../include/SonarRing.h"
+
+using namespace opendlv::proxy::miniature;
 
 class ProximityHcsr04Test : public CxxTest::TestSuite {
    public:
@@ -33,6 +50,263 @@ class ProximityHcsr04Test : public CxxTest::TestSuite {
     void testApplication() {
         TS_ASSERT(true);
     }
+
+    // Writes a sample the way the firmware does, returns false if full.
+    bool Push(volatile uint32_t *a_data, uint32_t a_sensor, uint32_t a_roundtrip, 
+        uint64_t a_triggerTimeNs) {
+        uint32_t const head = a_data[sonarprumemory::RING_HEAD];
+        uint32_t const next = (head + 1) % sonarprumemory::RING_SIZE;
+        if (next == a_data[sonarprumemory::RING_TAIL]) {
+            a_data[sonarprumemory::RING_DROPPED]++;
+            return false;
+        }
+        volatile uint32_t *entry = a_data + sonarprumemory::RING 
+            + head * sonarprumemory::RING_ENTRY_WORDS;
+        entry[0] = a_sensor;
+        entry[1] = a_roundtrip;
+        entry[2] = static_cast<uint32_t>(a_triggerTimeNs);
+        entry[3] = static_cast<uint32_t>(a_triggerTimeNs >> 32);
+        a_data[sonarprumemory::RING_HEAD] = next;
+        return true;
+    }
+
+    void testRingDrainsEverySampleInOrder() {
+        uint32_t data[2048] = {0};
+        SonarRing ring;
+        ring.Attach(data);
+        ring.Reset();
+
+        SonarSample samples[sonarprumemory::RING_SIZE];
+        TS_ASSERT_EQUALS(ring.Drain(samples, sonarprumemory::RING_SIZE), 0u);
+
+        // Wrap around the ring several times.
+        uint32_t next = 0;
+        uint32_t expected = 0;
+        for (uint32_t round = 0; round < 10; round++) {
+            for (uint32_t i = 0; i < 37; i++) {
+                TS_ASSERT(Push(data, next % 3, next, 
+                      (static_cast<uint64_t>(next) << 31) + 5));
+                next++;
+            }
+            uint32_t const count = ring.Drain(samples, sonarprumemory::RING_SIZE);
+            TS_ASSERT_EQUALS(count, 37u);
+            for (uint32_t i = 0; i < count; i++) {
+                TS_ASSERT_EQUALS(samples[i].sensorId, expected % 3);
+                TS_ASSERT_EQUALS(samples[i].echoCycles, expected);
+                TS_ASSERT_EQUALS(samples[i].triggerTimeNs, 
+                    (static_cast<uint64_t>(expected) << 31) + 5);
+                expected++;
+            }
+        }
+        TS_ASSERT_EQUALS(ring.GetDropped(), 0u);
+    }
+
+    void testRingFullDropsAndPartialDrain() {
+        uint32_t data[2048] = {0};
+        SonarRing ring;
+        ring.Attach(data);
+        ring.Reset();
+
+        // One entry is kept empty to tell a full ring from an empty one.
+        for (uint32_t i = 0; i < sonarprumemory::RING_SIZE - 1; i++) {
+            TS_ASSERT(Push(data, 0, i, i));
+        }
+        TS_ASSERT(!Push(data, 0, 1000, 1000));
+        TS_ASSERT_EQUALS(ring.GetDropped(), 1u);
+
+        SonarSample samples[10];
+        TS_ASSERT_EQUALS(ring.Drain(samples, 10), 10u);
+        TS_ASSERT_EQUALS(samples[9].echoCycles, 9u);
+        TS_ASSERT(Push(data, 0, 63, 63));
+
+        SonarSample rest[sonarprumemory::RING_SIZE];
+        TS_ASSERT_EQUALS(ring.Drain(rest, sonarprumemory::RING_SIZE), 54u);
+        TS_ASSERT_EQUALS(rest[0].echoCycles, 10u);
+        TS_ASSERT_EQUALS(rest[53].echoCycles, 63u);
+        TS_ASSERT_EQUALS(data[sonarprumemory::RING_TAIL], 
+            data[sonarprumemory::RING_HEAD]);
+    }
+
+    void testPruClockExtendsCounterOverWraps() {
+        PruClock clock;
+        TS_ASSERT(!clock.IsValid());
+
+        // The counter counts nanoseconds and wraps every 2^32 ns.
+        uint64_t pruNs = 0;
+        int64_t const offset = static_cast<int64_t>(1500000000) * 1000000000;
+        for (uint32_t i = 0; i < 20; i++) {
+            clock.Update(offset + static_cast<int64_t>(pruNs) - 1000, 
+                static_cast<uint32_t>(pruNs), 
+                offset + static_cast<int64_t>(pruNs) + 1000);
+            TS_ASSERT_EQUALS(clock.GetPruNs(), pruNs);
+            pruNs += 1000000000;
+        }
+        TS_ASSERT(clock.IsValid());
+        TS_ASSERT_EQUALS(clock.GetPruNs() >> 32, 4u);
+        TS_ASSERT_EQUALS(clock.GetOffsetNs(), offset);
+        int64_t const fiveSecondsNs = static_cast<int64_t>(5) * 1000000000;
+        TS_ASSERT_EQUALS(clock.ToHostNs(static_cast<uint64_t>(fiveSecondsNs)), 
+            offset + fiveSecondsNs);
+    }
+
+    void testPruClockUsesShortestWindow() {
+        PruClock clock;
+        int64_t const offset = 1000000;
+
+        // A reading delayed by preemption has a long window and a skewed
+        // midpoint, a reading with a short window is closer to the truth.
+        clock.Update(offset + 100000 - 200, 100000, offset + 100000 + 80000);
+        TS_ASSERT_EQUALS(clock.GetOffsetNs(), offset + 39900);
+        clock.Update(offset + 200000 - 300, 200000, offset + 200000 + 300);
+        TS_ASSERT_EQUALS(clock.GetOffsetNs(), offset);
+        clock.Update(offset + 300000 - 100, 300000, offset + 300000 + 90000);
+        TS_ASSERT_EQUALS(clock.GetOffsetNs(), offset);
+
+        // The best reading leaves the window after WINDOW_SIZE readings,
+        // which lets the offset follow drift.
+        for (uint32_t i = 0; i < PruClock::WINDOW_SIZE; i++) {
+            int64_t const pruNs = 400000 + i * 100000;
+            clock.Update(offset + 7000 + pruNs - 500, 
+                static_cast<uint32_t>(pruNs), offset + 7000 + pruNs + 500);
+        }
+        TS_ASSERT_EQUALS(clock.GetOffsetNs(), offset + 7000);
+    }
+
+    int64_t HostNowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    void testReceiverDeliversEverySampleFromSimulator() {
+        PruSimulator simulator;
+        TS_ASSERT(simulator.Open());
+        simulator.SetPeriodNs(500000);
+        simulator.SetEcho([](uint32_t, uint64_t a_sample) {
+            return static_cast<uint32_t>(a_sample);
+        });
+
+        std::mutex mutex;
+        std::vector<SonarSample> samples;
+        std::vector<int64_t> delaysNs;
+        SonarReceiver receiver(simulator, 
+            [&](SonarSample const &a_sample, int64_t a_sampleTimeNs) {
+                std::lock_guard<std::mutex> lock(mutex);
+                samples.push_back(a_sample);
+                delaysNs.push_back(HostNowNs() - a_sampleTimeNs);
+            });
+
+        std::vector<uint32_t> const sensors = {12 | (13 << 8), 14 | (15 << 8), 
+            16 | (17 << 8)};
+        TS_ASSERT(receiver.Start("hcsr04.bin", sensors, 0));
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        receiver.Stop();
+
+        uint64_t const produced = simulator.GetSampleCount();
+        TS_ASSERT(produced > 100);
+        TS_ASSERT_EQUALS(receiver.GetDropped(), 0u);
+        TS_ASSERT_EQUALS(simulator.GetDataRam()[sonarprumemory::SENSOR_COUNT], 3u);
+
+        // Everything produced before the stop is delivered once, in order.
+        TS_ASSERT(samples.size() + 1 >= produced);
+        for (uint32_t i = 0; i < samples.size(); i++) {
+            TS_ASSERT_EQUALS(samples[i].echoCycles, i);
+            TS_ASSERT_EQUALS(samples[i].sensorId, i % 3);
+            if (i > 0) {
+                TS_ASSERT(samples[i].triggerTimeNs > samples[i - 1].triggerTimeNs);
+            }
+        }
+
+        // Capture times are mapped to host time, never in the future.
+        std::sort(delaysNs.begin(), delaysNs.end());
+        TS_ASSERT(delaysNs.front() > -1000000);
+        TS_ASSERT(delaysNs[delaysNs.size() / 2] < 50000000);
+    }
+
+    void testReceiverStopsWithoutEvents() {
+        PruSimulator simulator;
+        TS_ASSERT(simulator.Open());
+        simulator.SetPeriodNs(4000000000u);
+
+        uint32_t count = 0;
+        SonarReceiver receiver(simulator, 
+            [&](SonarSample const &, int64_t) { count++; });
+        TS_ASSERT(receiver.Start("hcsr04.bin", {}, 0));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        auto start = std::chrono::steady_clock::now();
+        receiver.Stop();
+        auto end = std::chrono::steady_clock::now();
+        TS_ASSERT(end - start < std::chrono::milliseconds(1000));
+        TS_ASSERT_EQUALS(count, 1u);
+    }
+
+    void testReceiverLatencyBenchmark() {
+        PruSimulator simulator;
+        TS_ASSERT(simulator.Open());
+        simulator.SetPeriodNs(100000);
+
+        std::vector<int64_t> delaysNs;
+        delaysNs.reserve(100000);
+        SonarReceiver receiver(simulator, 
+            [&](SonarSample const &, int64_t a_sampleTimeNs) {
+                delaysNs.push_back(HostNowNs() - a_sampleTimeNs);
+            });
+        TS_ASSERT(receiver.Start("hcsr04.bin", {12 | (13 << 8)}, 0));
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        receiver.Stop();
+
+        TS_ASSERT(!delaysNs.empty());
+        if (delaysNs.empty()) {
+            return;
+        }
+        std::sort(delaysNs.begin(), delaysNs.end());
+        std::cout << std::endl << "Received " << delaysNs.size() << " of " 
+            << simulator.GetSampleCount() << " samples in 500 ms, "
+            << receiver.GetDropped() << " dropped, median delay " 
+            << delaysNs[delaysNs.size() / 2] / 1000 << " us, 99th percentile " 
+            << delaysNs[delaysNs.size() * 99 / 100] / 1000 << " us" << std::endl;
+    }
+
+    void testFilterRejectsSpikes() {
+        SonarFilter filter(5, 2.0f, 400.0f, 5.0f);
+        TS_ASSERT_DELTA(filter.GetDistance(), 400.0f, 1e-6);
+        TS_ASSERT_DELTA(filter.GetConfidence(), 0.0f, 1e-6);
+
+        float const distances[] = {50.0f, 51.0f, 250.0f, 49.0f, 3.0f, 50.0f};
+        for (float distance : distances) {
+            filter.Add(distance);
+        }
+        // Window 51, 250, 49, 3, 50 has the median 50, with three of five
+        // agreeing.
+        TS_ASSERT_DELTA(filter.GetDistance(), 50.0f, 1e-6);
+        TS_ASSERT_DELTA(filter.GetConfidence(), 0.6f, 1e-6);
+        TS_ASSERT(!filter.IsTimedOut());
+    }
+
+    void testFilterTimeoutsAndRange() {
+        SonarFilter filter(3, 2.0f, 400.0f, 5.0f);
+        filter.Add(100.0f);
+        TS_ASSERT_DELTA(filter.GetDistance(), 100.0f, 1e-6);
+        TS_ASSERT_DELTA(filter.GetConfidence(), 1.0f / 3.0f, 1e-6);
+
+        // Timeouts and out of range distances lower the confidence, but do
+        // not move the distance while valid distances remain.
+        filter.Add(std::nanf(""));
+        TS_ASSERT(filter.IsTimedOut());
+        filter.Add(1000.0f);
+        TS_ASSERT(!filter.IsTimedOut());
+        TS_ASSERT_DELTA(filter.GetDistance(), 100.0f, 1e-6);
+        TS_ASSERT_DELTA(filter.GetConfidence(), 1.0f / 3.0f, 1e-6);
+
+        // Nothing valid in the window is nothing within range.
+        filter.Add(1.0f);
+        TS_ASSERT_DELTA(filter.GetDistance(), 400.0f, 1e-6);
+        TS_ASSERT_DELTA(filter.GetConfidence(), 0.0f, 1e-6);
+
+        filter.Reset();
+        filter.Add(20.0f);
+        TS_ASSERT_DELTA(filter.GetDistance(), 20.0f, 1e-6);
+    }
 };
 
 #endif
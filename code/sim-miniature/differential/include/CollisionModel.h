@@ -0,0 +1,95 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef SIM_MINIATURE_COLLISIONMODEL_H
+#define SIM_MINIATURE_COLLISIONMODEL_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "WallGrid.h"
+
+namespace opendlv {
+namespace sim {
+namespace miniature {
+
+/**
+ * Keeps robots, seen as circles, out of the walls and out of each other. 
+ * The move of each robot over a substep is checked as a swept circle 
+ * against the nearby walls, and the robots are checked pairwise through a 
+ * spatial hash of their positions. A robot that moves into a wall either
+ * stays where it was (stop), or keeps the part of its move along the wall 
+ * (slide). Robots that touch stay where they were. A robot is only held 
+ * back while it moves closer, so it can always turn and leave.
+ */
+class CollisionModel {
+ public:
+  enum Response {
+    STOP,
+    SLIDE
+  };
+
+  CollisionModel(WallGrid const &, double const, Response const, bool const);
+  CollisionModel(CollisionModel const &) = delete;
+  CollisionModel &operator=(CollisionModel const &) = delete;
+  virtual ~CollisionModel();
+
+  static bool ParseResponse(std::string const &, Response &);
+  void Resolve(std::vector<double> const &, std::vector<double> const &, 
+      std::vector<double> &, std::vector<double> &);
+  uint32_t GetWallCollisions(uint32_t const) const;
+  uint32_t GetRobotCollisions(uint32_t const) const;
+
+ private:
+  void ClosestPoint(WallSegment const &, double const, double const, 
+      double &, double &) const;
+  bool Crosses(WallSegment const &, double const, double const, 
+      double const, double const) const;
+  bool HitsWall(double const, double const, double const, double const, 
+      double &, double &, double &);
+  void ResolveWalls(uint32_t const, std::vector<double> const &, 
+      std::vector<double> const &, std::vector<double> &, 
+      std::vector<double> &);
+  bool ResolveRobots(std::vector<double> const &, std::vector<double> const &,
+      std::vector<double> &, std::vector<double> &);
+  void Resize(uint32_t const);
+
+  WallGrid const &m_walls;
+  double m_radius;
+  Response m_response;
+  bool m_robotCollisions;
+  std::vector<uint32_t> m_candidates;
+  std::vector<uint32_t> m_wallCollisions;
+  std::vector<uint32_t> m_robotCollisionCounts;
+  std::vector<bool> m_inWallContact;
+  std::vector<bool> m_inRobotContact;
+  std::vector<bool> m_robotContact;
+  std::vector<uint32_t> m_bucketStart;
+  std::vector<uint32_t> m_bucketRobots;
+  std::vector<uint32_t> m_robotBucket;
+
+  static double const CONTACT_MARGIN;
+  static uint32_t const MAX_ROBOT_PASSES = 4;
+};
+
+}
+}
+}
+
+#endif
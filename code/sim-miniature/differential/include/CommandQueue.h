@@ -0,0 +1,76 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef SIM_MINIATURE_COMMANDQUEUE_H
+#define SIM_MINIATURE_COMMANDQUEUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace opendlv {
+namespace sim {
+namespace miniature {
+
+/**
+ * A motor command for one robot, either the duty cycle of a wheel or the
+ * state of a motor control pin.
+ */
+struct CommandUpdate {
+  enum Kind {
+    DUTY_CYCLE,
+    TOGGLE
+  };
+
+  Kind kind;
+  uint32_t robot;
+  uint16_t channel;
+  uint32_t value;
+};
+
+/**
+ * Single producer, single consumer ring of motor commands, from the thread
+ * receiving containers to the simulation loop. The producer only writes 
+ * the entries and the head, the consumer only writes the tail, so neither
+ * side ever waits for the other. Commands that do not fit are dropped and
+ * counted.
+ */
+class CommandQueue {
+ public:
+  explicit CommandQueue(uint32_t const);
+  CommandQueue(CommandQueue const &) = delete;
+  CommandQueue &operator=(CommandQueue const &) = delete;
+  virtual ~CommandQueue();
+
+  bool Push(CommandUpdate const &);
+  uint32_t Drain(std::vector<CommandUpdate> &);
+  uint32_t GetDropped() const;
+
+ private:
+  std::vector<CommandUpdate> m_entries;
+  uint32_t m_mask;
+  std::atomic<uint32_t> m_head;
+  std::atomic<uint32_t> m_tail;
+  std::atomic<uint32_t> m_dropped;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,76 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef SIM_MINIATURE_DELAYLINE_H
+#define SIM_MINIATURE_DELAYLINE_H
+
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace opendlv {
+namespace sim {
+namespace miniature {
+
+/**
+ * Holds items until the time they are due. Items come out in the order 
+ * they are due, and in the order they were pushed when due together.
+ */
+template<typename T>
+class DelayLine {
+ public:
+  DelayLine()
+      : m_items()
+  {
+  }
+
+  virtual ~DelayLine()
+  {
+  }
+
+  void Push(double const a_due, T const &a_item)
+  {
+    m_items.insert(std::make_pair(a_due, a_item));
+  }
+
+  /**
+   * Moves the items due at the time to the end of the output.
+   */
+  void PopDue(double const a_time, std::vector<T> &a_items)
+  {
+    auto end = m_items.upper_bound(a_time);
+    for (auto it = m_items.begin(); it != end; it++) {
+      a_items.push_back(it->second);
+    }
+    m_items.erase(m_items.begin(), end);
+  }
+
+  uint32_t GetSize() const
+  {
+    return static_cast<uint32_t>(m_items.size());
+  }
+
+ private:
+  std::multimap<double, T> m_items;
+};
+
+}
+}
+}
+
+#endif
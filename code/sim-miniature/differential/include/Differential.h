@@ -19,20 +19,47 @@
 #ifndef SIM_MINIATURE_DIFFERENTIAL_H
 #define SIM_MINIATURE_DIFFERENTIAL_H
 
+#include <atomic>
+#include <fstream>
 #include <memory>
+#include <random>
 #include <string>
+#include <utility>
 #include <vector>
 
-#include <opendavinci/odcore/base/Mutex.h>
+#include <opendavinci/odcore/data/Container.h>
 #include <opendavinci/odcore/base/module/TimeTriggeredConferenceClientModule.h>
 
-#include <automotivedata/GeneratedHeaders_AutomotiveData.h>
 #include <opendlv/data/environment/EgoState.h>
 
+#include "CollisionModel.h"
+#include "CommandQueue.h"
+#include "DelayLine.h"
+#include "DifferentialDrive.h"
+#include "FaultModel.h"
+#include "Fleet.h"
+#include "MotorModel.h"
+#include "RangeSensor.h"
+#include "TickCounters.h"
+#include "WallGrid.h"
+#include "WorldSnapshot.h"
+
 namespace opendlv {
 namespace sim {
 namespace miniature {
 
+/**
+ * The motor driver inputs of one robot, as last commanded.
+ */
+struct MotorCommand {
+  bool gpioInA;
+  bool gpioInB;
+  bool gpioInC;
+  bool gpioInD;
+  uint32_t leftDutyCycleNs;
+  uint32_t rightDutyCycleNs;
+};
+
 class Differential : 
   public odcore::base::module::TimeTriggeredConferenceClientModule {
  public:
@@ -46,21 +73,53 @@ class Differential :
   virtual void setUp();
   virtual void tearDown();
   odcore::data::dmcp::ModuleExitCodeMessage::ModuleExitCode body();
-  void ConvertPwmToWheelAngularVelocity(uint16_t, uint32_t);
-  void ConvertBoardDataToSensorReading(
-    automotive::miniature::SensorBoardData const &);
-  void SetMotorControl(uint16_t, bool);
+  void ApplyCommands();
+  bool GetRobotIndex(uint32_t, uint32_t &) const;
+  double ConvertPwmToWheelAngularVelocity(uint32_t, int32_t) const;
+  int32_t GetMotorDirection(bool, bool) const;
+  void SetDutyCycle(uint32_t, uint16_t, uint32_t);
+  void ReadWalls(std::string const &);
+  void ReadScenarioWalls(std::string const &, double);
+  void SimulateSensors(DifferentialPose const &);
+  void Publish(odcore::data::Container &);
+  void Send(odcore::data::Container &);
+  void ReportTickCounters();
+  bool SaveSnapshot(std::string const &);
+  bool RestoreSnapshot(std::string const &);
+  void SetMotorControl(uint32_t, uint16_t, bool);
+  float ConvertDistanceToVoltage(double) const;
 
-  odcore::base::Mutex m_mutex;
   opendlv::data::environment::EgoState m_currentEgoState;
   bool m_debug;
-  bool m_gpioInA;
-  bool m_gpioInB;
-  bool m_gpioInC;
-  bool m_gpioInD;
   double m_deltaTime;
-  double m_leftWheelAngularVelocity;
-  double m_rightWheelAngularVelocity;
+  double m_simulationTime;
+  double m_simulationDuration;
+  std::vector<MotorCommand> m_commands;
+  std::vector<std::pair<double, float>> m_irCalibration;
+  std::unique_ptr<Fleet> m_fleet;
+  std::unique_ptr<MotorModel> m_motorModel;
+  bool m_hBridge;
+  uint16_t m_leftPwmPin;
+  uint16_t m_rightPwmPin;
+  WallGrid m_walls;
+  std::unique_ptr<CollisionModel> m_collisionModel;
+  std::vector<RangeSensor> m_sensors;
+  std::mt19937 m_random;
+  std::unique_ptr<FaultModel> m_faults;
+  DelayLine<odcore::data::Container> m_delayLine;
+  CommandQueue m_commandQueue;
+  std::vector<CommandUpdate> m_updates;
+  uint32_t m_droppedCommands;
+  std::atomic<bool> m_initialised;
+  std::string m_snapshotFile;
+  double m_snapshotTime;
+  std::unique_ptr<common::miniature::TickCounters> m_tickCounters;
+  std::atomic<uint32_t> m_messagesIn;
+  uint32_t m_statisticsTicks;
+  std::ofstream m_statisticsFile;
+
+  static uint32_t const COMMAND_QUEUE_SIZE = 1024;
+  static uint32_t const TICK_HISTOGRAM_BINS = 40;
 };
 
 }
@@ -0,0 +1,77 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef SIM_MINIATURE_DIFFERENTIALDRIVE_H
+#define SIM_MINIATURE_DIFFERENTIALDRIVE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace opendlv {
+namespace sim {
+namespace miniature {
+
+/**
+ * Planar pose in meters and radians.
+ */
+struct DifferentialPose {
+  double x;
+  double y;
+  double yaw;
+};
+
+class Fleet;
+
+/**
+ * Kinematics of a differential drive, a unicycle driven by the angular
+ * velocities of its left and right wheel, where positive is forward. A step
+ * is split into substeps no longer than the substep time, each integrated
+ * with the chosen method. The drive is a fleet of one, so that a single 
+ * robot and a fleet are integrated by the same code.
+ */
+class DifferentialDrive {
+ public:
+  enum Integrator {
+    EULER,
+    MIDPOINT,
+    RK4
+  };
+
+  DifferentialDrive(double const, double const, Integrator const, 
+      double const);
+  DifferentialDrive(DifferentialDrive const &) = delete;
+  DifferentialDrive &operator=(DifferentialDrive const &) = delete;
+  virtual ~DifferentialDrive();
+
+  static bool ParseIntegrator(std::string const &, Integrator &);
+
+  void SetWheelAngularVelocities(double const, double const);
+  double GetLinearVelocity() const;
+  double GetYawRate() const;
+  uint32_t Step(DifferentialPose &, double const);
+
+ private:
+  std::unique_ptr<Fleet> m_fleet;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,70 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef SIM_MINIATURE_FAULTMODEL_H
+#define SIM_MINIATURE_FAULTMODEL_H
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "DifferentialDrive.h"
+
+namespace opendlv {
+namespace sim {
+namespace miniature {
+
+/**
+ * Faults applied to the simulated measurements before they are sent: 
+ * gaussian noise on poses, messages that are dropped or delayed, and 
+ * sensors that get stuck at their last reading for a while. Messages are
+ * delayed by a latency plus a uniform jitter, so messages sent close 
+ * together can arrive out of order. All draws come from the given random
+ * engine, so that a seeded engine gives the same faults every run.
+ */
+class FaultModel {
+ public:
+  FaultModel(double const, double const, double const, double const, 
+      double const, double const, double const);
+  virtual ~FaultModel();
+
+  void AddPoseNoise(DifferentialPose &, std::mt19937 &) const;
+  bool IsDropped(std::mt19937 &) const;
+  double GetDelay(std::mt19937 &) const;
+  void ApplyStuck(uint32_t const, double const, bool &, double &, 
+      std::mt19937 &);
+  bool IsStuck(uint32_t const, double const) const;
+
+ private:
+  double m_positionNoise;
+  double m_yawNoise;
+  double m_dropout;
+  double m_latency;
+  double m_latencyJitter;
+  double m_stuckProbability;
+  double m_stuckDuration;
+  std::vector<double> m_stuckUntil;
+  std::vector<bool> m_stuckFound;
+  std::vector<double> m_stuckDistance;
+};
+
+}
+}
+}
+
+#endif
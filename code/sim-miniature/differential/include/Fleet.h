@@ -0,0 +1,94 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef SIM_MINIATURE_FLEET_H
+#define SIM_MINIATURE_FLEET_H
+
+#include <cstdint>
+#include <vector>
+
+#include "CollisionModel.h"
+#include "DifferentialDrive.h"
+
+namespace opendlv {
+namespace sim {
+namespace miniature {
+
+/**
+ * A number of differential drive robots with the same geometry, kept as a 
+ * structure of arrays. Each substep is integrated with the wheel speeds 
+ * held, one loop over all robots per integration stage. The wheels 
+ * approach their target velocities with a first order lag, updated at each
+ * substep. With a collision model, the positions are corrected after each
+ * substep.
+ */
+class Fleet {
+ public:
+  Fleet(uint32_t const, double const, double const, 
+      DifferentialDrive::Integrator const, double const);
+  Fleet(Fleet const &) = delete;
+  Fleet &operator=(Fleet const &) = delete;
+  virtual ~Fleet();
+
+  uint32_t GetSize() const;
+  void SetPose(uint32_t const, DifferentialPose const &);
+  DifferentialPose GetPose(uint32_t const) const;
+  void SetWheelAngularVelocities(uint32_t const, double const, double const);
+  void SetWheelTargets(uint32_t const, double const, double const);
+  void GetWheelAngularVelocities(uint32_t const, double &, double &) const;
+  void GetWheelTargets(uint32_t const, double &, double &) const;
+  void SetTimeConstant(double const);
+  double GetLinearVelocity(uint32_t const) const;
+  double GetYawRate(uint32_t const) const;
+  uint32_t Step(double const);
+  void SetCollisionModel(CollisionModel *);
+
+ private:
+  void Substep(double const);
+  void UpdateWheels(double const);
+  void EvaluateStage(double const);
+
+  uint32_t m_size;
+  double m_wheelRadius;
+  double m_trackWidth;
+  DifferentialDrive::Integrator m_integrator;
+  double m_substepTime;
+  double m_timeConstant;
+  std::vector<double> m_x;
+  std::vector<double> m_y;
+  std::vector<double> m_yaw;
+  std::vector<double> m_linearVelocity;
+  std::vector<double> m_yawRate;
+  std::vector<double> m_leftWheel;
+  std::vector<double> m_rightWheel;
+  std::vector<double> m_leftTarget;
+  std::vector<double> m_rightTarget;
+  std::vector<double> m_prevX;
+  std::vector<double> m_prevY;
+  std::vector<double> m_stageX;
+  std::vector<double> m_stageY;
+  std::vector<double> m_sumX;
+  std::vector<double> m_sumY;
+  CollisionModel *m_collisionModel;
+};
+
+}
+}
+}
+
+#endif
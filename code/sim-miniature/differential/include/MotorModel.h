@@ -0,0 +1,62 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef SIM_MINIATURE_MOTORMODEL_H
+#define SIM_MINIATURE_MOTORMODEL_H
+
+#include <cstdint>
+
+namespace opendlv {
+namespace sim {
+namespace miniature {
+
+/**
+ * Maps the pulse width driving a wheel motor to the wheel angular velocity
+ * it settles at. The pulse is taken relative to a neutral width, as for a
+ * continuous rotation servo, which gives a command from -1 to 1. With the 
+ * neutral width at the minimum, as for an H-bridge, the command is from 0 
+ * to 1 and the direction is set elsewhere. Commands within the deadband 
+ * give no motion, and the rest of the range follows a power curve up to 
+ * the maximum angular velocity. The motor reaches the velocity with a 
+ * first order lag of the time constant.
+ */
+class MotorModel {
+ public:
+  MotorModel(uint32_t const, uint32_t const, uint32_t const, double const, 
+      double const, double const, double const);
+  virtual ~MotorModel();
+
+  double GetCommand(uint32_t const) const;
+  double GetAngularVelocity(double const) const;
+  double GetTimeConstant() const;
+
+ private:
+  uint32_t m_minPulseNs;
+  uint32_t m_neutralPulseNs;
+  uint32_t m_maxPulseNs;
+  double m_deadband;
+  double m_exponent;
+  double m_maxAngularVelocity;
+  double m_timeConstant;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,64 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef SIM_MINIATURE_RANGESENSOR_H
+#define SIM_MINIATURE_RANGESENSOR_H
+
+#include <cstdint>
+#include <random>
+
+#include "DifferentialDrive.h"
+#include "WallGrid.h"
+
+namespace opendlv {
+namespace sim {
+namespace miniature {
+
+/**
+ * An IR or ultrasonic sensor mounted on a robot, given by its position and
+ * heading in the robot frame, its field of view and range. The beam is a 
+ * fan of rays over the field of view, and the nearest wall any of them hits
+ * is measured, with gaussian noise added.
+ */
+class RangeSensor {
+ public:
+  RangeSensor(uint32_t const, double const, double const, double const, 
+      double const, double const, uint32_t const, double const);
+  virtual ~RangeSensor();
+
+  uint32_t GetId() const;
+  double GetRange() const;
+  bool Measure(WallGrid const &, DifferentialPose const &, std::mt19937 &, 
+      double &) const;
+
+ private:
+  uint32_t m_id;
+  double m_x;
+  double m_y;
+  double m_angle;
+  double m_fieldOfView;
+  double m_range;
+  uint32_t m_rays;
+  double m_noise;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,77 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef SIM_MINIATURE_WALLGRID_H
+#define SIM_MINIATURE_WALLGRID_H
+
+#include <cstdint>
+#include <vector>
+
+namespace opendlv {
+namespace sim {
+namespace miniature {
+
+struct WallSegment {
+  double x1;
+  double y1;
+  double x2;
+  double y2;
+};
+
+/**
+ * Wall segments sorted into a uniform grid of square cells, so that a ray 
+ * only tests the segments in the cells it passes, nearest cells first. The
+ * cells keep indices into one flat array. Segments are added first, then
+ * the grid is built once.
+ */
+class WallGrid {
+ public:
+  WallGrid();
+  virtual ~WallGrid();
+
+  void AddSegment(WallSegment const &);
+  void AddPolygon(std::vector<double> const &, std::vector<double> const &);
+  void Build(double const);
+  uint32_t GetSegmentCount() const;
+  WallSegment const &GetSegment(uint32_t const) const;
+  void FindSegments(double const, double const, double const, double const,
+      std::vector<uint32_t> &) const;
+  bool CastRay(double const, double const, double const, double const, 
+      double &) const;
+
+  static uint32_t const MAX_CELLS = 1 << 20;
+
+ private:
+  bool IntersectCell(uint32_t const, double const, double const, 
+      double const, double const, double &) const;
+
+  std::vector<WallSegment> m_segments;
+  double m_minX;
+  double m_minY;
+  double m_cellSize;
+  int32_t m_columns;
+  int32_t m_rows;
+  std::vector<uint32_t> m_cellStart;
+  std::vector<uint32_t> m_cellSegments;
+};
+
+}
+}
+}
+
+#endif
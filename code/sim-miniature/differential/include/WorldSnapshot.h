@@ -0,0 +1,90 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef SIM_MINIATURE_WORLDSNAPSHOT_H
+#define SIM_MINIATURE_WORLDSNAPSHOT_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace opendlv {
+namespace sim {
+namespace miniature {
+
+/**
+ * The state of one simulated robot: its pose, the wheel angular 
+ * velocities and the ones they approach, and the last motor commands, with
+ * the motor control pins A to D as the lowest four bits.
+ */
+struct RobotSnapshot {
+  double x;
+  double y;
+  double yaw;
+  double leftWheel;
+  double rightWheel;
+  double leftTarget;
+  double rightTarget;
+  uint32_t leftDutyCycleNs;
+  uint32_t rightDutyCycleNs;
+  uint8_t gpio;
+};
+
+/**
+ * The state of a simulation at a point in simulated time, from which it 
+ * can be continued, or forked into several runs. It is stored as a 
+ * compact binary in host byte order: a magic and version, the simulated 
+ * time, the state words and index of the random generator and then the 
+ * robots.
+ */
+class WorldSnapshot {
+ public:
+  WorldSnapshot();
+  virtual ~WorldSnapshot();
+
+  bool Write(std::ostream &) const;
+  bool Read(std::istream &);
+  bool Save(std::string const &) const;
+  bool Load(std::string const &);
+  void SetRandom(std::mt19937 const &);
+  bool GetRandom(std::mt19937 &) const;
+
+  double simulationTime;
+  std::vector<uint32_t> randomWords;
+  uint32_t randomIndex;
+  std::vector<RobotSnapshot> robots;
+
+  static uint32_t const MAGIC = 0x504e5344;
+  static uint32_t const VERSION = 2;
+  static uint32_t const RANDOM_WORDS = std::mt19937::state_size;
+
+ private:
+  template<typename T>
+  static void WriteValue(std::ostream &, T const &);
+  template<typename T>
+  static bool ReadValue(std::istream &, T &);
+};
+
+}
+}
+}
+
+#endif
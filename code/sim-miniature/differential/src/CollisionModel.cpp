@@ -0,0 +1,352 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "CollisionModel.h"
+
+namespace opendlv {
+namespace sim {
+namespace miniature {
+
+// A robot stays in contact while it is this share of its radius from
+// what it hit, so that sliding along a wall counts as one collision.
+double const CollisionModel::CONTACT_MARGIN = 0.01;
+
+uint32_t const CollisionModel::MAX_ROBOT_PASSES;
+
+CollisionModel::CollisionModel(WallGrid const &a_walls, 
+    double const a_radius, Response const a_response, 
+    bool const a_robotCollisions)
+    : m_walls(a_walls)
+    , m_radius(a_radius)
+    , m_response(a_response)
+    , m_robotCollisions(a_robotCollisions)
+    , m_candidates()
+    , m_wallCollisions()
+    , m_robotCollisionCounts()
+    , m_inWallContact()
+    , m_inRobotContact()
+    , m_robotContact()
+    , m_bucketStart()
+    , m_bucketRobots()
+    , m_robotBucket()
+{
+}
+
+CollisionModel::~CollisionModel()
+{
+}
+
+/**
+ * Parses "stop" or "slide".
+ */
+bool CollisionModel::ParseResponse(std::string const &a_name, 
+    Response &a_response)
+{
+  if (a_name == "stop") {
+    a_response = STOP;
+  } else if (a_name == "slide") {
+    a_response = SLIDE;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Corrects the positions of all robots after a substep, given the 
+ * positions before it.
+ */
+void CollisionModel::Resolve(std::vector<double> const &a_prevX, 
+    std::vector<double> const &a_prevY, std::vector<double> &a_x, 
+    std::vector<double> &a_y)
+{
+  uint32_t const size = static_cast<uint32_t>(a_x.size());
+  Resize(size);
+  if (m_walls.GetSegmentCount() > 0) {
+    for (uint32_t i = 0; i < size; i++) {
+      ResolveWalls(i, a_prevX, a_prevY, a_x, a_y);
+    }
+  }
+  if (m_robotCollisions && size > 1) {
+    // Moving a robot back can make it touch another one, so the robots are
+    // checked again until none is moved, up to a limit.
+    std::fill(m_robotContact.begin(), m_robotContact.end(), false);
+    for (uint32_t pass = 0; pass < MAX_ROBOT_PASSES; pass++) {
+      if (!ResolveRobots(a_prevX, a_prevY, a_x, a_y)) {
+        break;
+      }
+    }
+    for (uint32_t i = 0; i < size; i++) {
+      m_inRobotContact[i] = m_inRobotContact[i] && m_robotContact[i];
+    }
+  }
+}
+
+/**
+ * Returns the number of times a robot has run into a wall.
+ */
+uint32_t CollisionModel::GetWallCollisions(uint32_t const a_index) const
+{
+  return (a_index < m_wallCollisions.size()) ? m_wallCollisions[a_index] : 0;
+}
+
+/**
+ * Returns the number of times a robot has run into another robot.
+ */
+uint32_t CollisionModel::GetRobotCollisions(uint32_t const a_index) const
+{
+  return (a_index < m_robotCollisionCounts.size()) 
+      ? m_robotCollisionCounts[a_index] : 0;
+}
+
+void CollisionModel::Resize(uint32_t const a_size)
+{
+  if (m_wallCollisions.size() != a_size) {
+    m_wallCollisions.assign(a_size, 0);
+    m_robotCollisionCounts.assign(a_size, 0);
+    m_inWallContact.assign(a_size, false);
+    m_inRobotContact.assign(a_size, false);
+    m_robotContact.assign(a_size, false);
+    m_robotBucket.assign(a_size, 0);
+    m_bucketRobots.assign(a_size, 0);
+    uint32_t buckets = 1;
+    while (buckets < 2 * a_size) {
+      buckets *= 2;
+    }
+    m_bucketStart.assign(buckets + 1, 0);
+  }
+}
+
+void CollisionModel::ClosestPoint(WallSegment const &a_segment, 
+    double const a_x, double const a_y, double &a_closestX, 
+    double &a_closestY) const
+{
+  double const ex = a_segment.x2 - a_segment.x1;
+  double const ey = a_segment.y2 - a_segment.y1;
+  double const lengthSquared = ex * ex + ey * ey;
+  double t = 0.0;
+  if (lengthSquared > 0.0) {
+    t = ((a_x - a_segment.x1) * ex + (a_y - a_segment.y1) * ey) 
+        / lengthSquared;
+    t = std::min(std::max(t, 0.0), 1.0);
+  }
+  a_closestX = a_segment.x1 + t * ex;
+  a_closestY = a_segment.y1 + t * ey;
+}
+
+/**
+ * Checks if a move crosses a wall.
+ */
+bool CollisionModel::Crosses(WallSegment const &a_segment, double const a_x0,
+    double const a_y0, double const a_x1, double const a_y1) const
+{
+  double const dx = a_x1 - a_x0;
+  double const dy = a_y1 - a_y0;
+  double const ex = a_segment.x2 - a_segment.x1;
+  double const ey = a_segment.y2 - a_segment.y1;
+  double const denominator = dx * ey - dy * ex;
+  if (std::abs(denominator) < 1e-15) {
+    return false;
+  }
+  double const wx = a_segment.x1 - a_x0;
+  double const wy = a_segment.y1 - a_y0;
+  double const t = (wx * ey - wy * ex) / denominator;
+  double const u = (wx * dy - wy * dx) / denominator;
+  return (t >= 0.0 && t <= 1.0 && u >= 0.0 && u <= 1.0);
+}
+
+/**
+ * Checks a move of a robot against the nearby walls. The move hits a wall
+ * if the swept circle reaches it while getting closer, or if the move 
+ * crosses it. Gives the normal away from the wall nearest to the start, 
+ * and the distance from the end to the nearest wall.
+ */
+bool CollisionModel::HitsWall(double const a_x0, double const a_y0, 
+    double const a_x1, double const a_y1, double &a_normalX, 
+    double &a_normalY, double &a_nearest)
+{
+  m_walls.FindSegments(std::min(a_x0, a_x1) - m_radius, 
+      std::min(a_y0, a_y1) - m_radius, std::max(a_x0, a_x1) + m_radius, 
+      std::max(a_y0, a_y1) + m_radius, m_candidates);
+
+  bool hit = false;
+  double hitDistance = std::numeric_limits<double>::max();
+  a_nearest = std::numeric_limits<double>::max();
+  for (uint32_t index : m_candidates) {
+    WallSegment const &segment = m_walls.GetSegment(index);
+    double cx0;
+    double cy0;
+    ClosestPoint(segment, a_x0, a_y0, cx0, cy0);
+    double cx1;
+    double cy1;
+    ClosestPoint(segment, a_x1, a_y1, cx1, cy1);
+    double const distance0 = std::hypot(a_x0 - cx0, a_y0 - cy0);
+    double const distance1 = std::hypot(a_x1 - cx1, a_y1 - cy1);
+    a_nearest = std::min(a_nearest, distance1);
+
+    bool const crosses = Crosses(segment, a_x0, a_y0, a_x1, a_y1);
+    if (!crosses && !(distance1 < m_radius && distance1 < distance0)) {
+      continue;
+    }
+    if (distance0 < hitDistance) {
+      hitDistance = distance0;
+      if (distance0 > 0.0) {
+        a_normalX = (a_x0 - cx0) / distance0;
+        a_normalY = (a_y0 - cy0) / distance0;
+      } else {
+        double const length = std::hypot(segment.x2 - segment.x1, 
+            segment.y2 - segment.y1);
+        a_normalX = -(segment.y2 - segment.y1) / length;
+        a_normalY = (segment.x2 - segment.x1) / length;
+      }
+    }
+    hit = true;
+  }
+  return hit;
+}
+
+void CollisionModel::ResolveWalls(uint32_t const a_index, 
+    std::vector<double> const &a_prevX, std::vector<double> const &a_prevY, 
+    std::vector<double> &a_x, std::vector<double> &a_y)
+{
+  double const x0 = a_prevX[a_index];
+  double const y0 = a_prevY[a_index];
+  double normalX = 0.0;
+  double normalY = 0.0;
+  double nearest;
+  bool const hit = HitsWall(x0, y0, a_x[a_index], a_y[a_index], normalX, 
+      normalY, nearest);
+
+  if (hit) {
+    if (!m_inWallContact[a_index]) {
+      m_wallCollisions[a_index]++;
+    }
+    bool stopped = true;
+    if (m_response == SLIDE) {
+      // Keep the part of the move along the wall, unless that also hits.
+      double dx = a_x[a_index] - x0;
+      double dy = a_y[a_index] - y0;
+      double const into = dx * normalX + dy * normalY;
+      if (into < 0.0) {
+        dx -= into * normalX;
+        dy -= into * normalY;
+      }
+      double slideNormalX;
+      double slideNormalY;
+      if (!HitsWall(x0, y0, x0 + dx, y0 + dy, slideNormalX, slideNormalY, 
+            nearest)) {
+        a_x[a_index] = x0 + dx;
+        a_y[a_index] = y0 + dy;
+        stopped = false;
+      }
+    }
+    if (stopped) {
+      a_x[a_index] = x0;
+      a_y[a_index] = y0;
+    }
+  }
+  m_inWallContact[a_index] = hit || (m_inWallContact[a_index] 
+      && nearest < m_radius * (1.0 + CONTACT_MARGIN));
+}
+
+/**
+ * Checks the robots pairwise within the neighbouring cells of a spatial 
+ * hash with cells of one robot diameter, built again at each pass. Returns
+ * true if a robot was moved back.
+ */
+bool CollisionModel::ResolveRobots(std::vector<double> const &a_prevX, 
+    std::vector<double> const &a_prevY, std::vector<double> &a_x, 
+    std::vector<double> &a_y)
+{
+  uint32_t const size = static_cast<uint32_t>(a_x.size());
+  uint32_t const buckets = static_cast<uint32_t>(m_bucketStart.size()) - 1;
+  double const cellSize = 2.0 * m_radius;
+
+  std::fill(m_bucketStart.begin(), m_bucketStart.end(), 0);
+  for (uint32_t i = 0; i < size; i++) {
+    int64_t const column = static_cast<int64_t>(std::floor(a_x[i] / cellSize));
+    int64_t const row = static_cast<int64_t>(std::floor(a_y[i] / cellSize));
+    uint32_t const bucket = static_cast<uint32_t>(
+        (column * 73856093) ^ (row * 19349663)) & (buckets - 1);
+    m_robotBucket[i] = bucket;
+    m_bucketStart[bucket]++;
+  }
+  // Each bucket is filled from its end, which leaves its start.
+  for (uint32_t b = 1; b <= buckets; b++) {
+    m_bucketStart[b] += m_bucketStart[b - 1];
+  }
+  for (uint32_t i = 0; i < size; i++) {
+    m_bucketRobots[--m_bucketStart[m_robotBucket[i]]] = i;
+  }
+  bool moved = false;
+  double const diameterSquared = cellSize * cellSize;
+  for (uint32_t i = 0; i < size; i++) {
+    int64_t const column = static_cast<int64_t>(std::floor(a_x[i] / cellSize));
+    int64_t const row = static_cast<int64_t>(std::floor(a_y[i] / cellSize));
+    for (int64_t r = row - 1; r <= row + 1; r++) {
+      for (int64_t c = column - 1; c <= column + 1; c++) {
+        uint32_t const bucket = static_cast<uint32_t>(
+            (c * 73856093) ^ (r * 19349663)) & (buckets - 1);
+        for (uint32_t k = m_bucketStart[bucket]; 
+            k < m_bucketStart[bucket + 1]; k++) {
+          uint32_t const j = m_bucketRobots[k];
+          if (j <= i) {
+            continue;
+          }
+          double const dx1 = a_x[i] - a_x[j];
+          double const dy1 = a_y[i] - a_y[j];
+          double const distanceSquared1 = dx1 * dx1 + dy1 * dy1;
+          if (distanceSquared1 >= diameterSquared * (1.0 + CONTACT_MARGIN)) {
+            continue;
+          }
+          m_robotContact[i] = true;
+          m_robotContact[j] = true;
+          double const dx0 = a_prevX[i] - a_prevX[j];
+          double const dy0 = a_prevY[i] - a_prevY[j];
+          if (distanceSquared1 < diameterSquared 
+              && distanceSquared1 < dx0 * dx0 + dy0 * dy0) {
+            if (!m_inRobotContact[i]) {
+              m_robotCollisionCounts[i]++;
+              m_inRobotContact[i] = true;
+            }
+            if (!m_inRobotContact[j]) {
+              m_robotCollisionCounts[j]++;
+              m_inRobotContact[j] = true;
+            }
+            a_x[i] = a_prevX[i];
+            a_y[i] = a_prevY[i];
+            a_x[j] = a_prevX[j];
+            a_y[j] = a_prevY[j];
+            moved = true;
+          }
+        }
+      }
+    }
+  }
+  return moved;
+}
+
+}
+}
+}
@@ -0,0 +1,89 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <atomic>
+#include <vector>
+
+#include "CommandQueue.h"
+
+namespace opendlv {
+namespace sim {
+namespace miniature {
+
+/**
+ * The capacity is rounded up to a power of two.
+ */
+CommandQueue::CommandQueue(uint32_t const a_capacity)
+    : m_entries()
+    , m_mask(0)
+    , m_head(0)
+    , m_tail(0)
+    , m_dropped(0)
+{
+  uint32_t size = 2;
+  while (size < a_capacity) {
+    size *= 2;
+  }
+  CommandUpdate const empty = {CommandUpdate::DUTY_CYCLE, 0, 0, 0};
+  m_entries.assign(size, empty);
+  m_mask = size - 1;
+}
+
+CommandQueue::~CommandQueue()
+{
+}
+
+/**
+ * Adds a command, called by the producer only.
+ */
+bool CommandQueue::Push(CommandUpdate const &a_update)
+{
+  uint32_t const head = m_head.load(std::memory_order_relaxed);
+  uint32_t const tail = m_tail.load(std::memory_order_acquire);
+  if (head - tail > m_mask) {
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  m_entries[head & m_mask] = a_update;
+  m_head.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+/**
+ * Moves all queued commands to the end of the output in the order they 
+ * were pushed, called by the consumer only.
+ */
+uint32_t CommandQueue::Drain(std::vector<CommandUpdate> &a_updates)
+{
+  uint32_t const tail = m_tail.load(std::memory_order_relaxed);
+  uint32_t const head = m_head.load(std::memory_order_acquire);
+  for (uint32_t i = tail; i != head; i++) {
+    a_updates.push_back(m_entries[i & m_mask]);
+  }
+  m_tail.store(head, std::memory_order_release);
+  return head - tail;
+}
+
+uint32_t CommandQueue::GetDropped() const
+{
+  return m_dropped.load(std::memory_order_relaxed);
+}
+
+}
+}
+}
@@ -16,16 +16,28 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
 #include <iostream>
+#include <random>
 #include <string>
+#include <utility>
+#include <vector>
 #include <math.h>
 
 #include <opendavinci/odcore/base/KeyValueConfiguration.h>
-#include <opendavinci/odcore/base/Lock.h>
 #include <opendavinci/odcore/data/Container.h>
 #include <opendavinci/odcore/data/TimeStamp.h>
+#include <opendavinci/odcore/io/URL.h>
+#include <opendavinci/odcore/strings/StringToolbox.h>
 
 #include <opendlv/data/environment/Point3.h>
+#include <opendlv/data/scenario/Polygon.h>
+#include <opendlv/data/scenario/SCNXArchive.h>
+#include <opendlv/data/scenario/SCNXArchiveFactory.h>
+#include <opendlv/data/scenario/Vertex3.h>
 
 #include <odvdopendlvdata/GeneratedHeaders_ODVDOpenDLVData.h>
 #include <odvdminiature/GeneratedHeaders_ODVDMiniature.h>
@@ -36,19 +48,40 @@ namespace opendlv {
 namespace sim {
 namespace miniature {
 
+uint32_t const Differential::COMMAND_QUEUE_SIZE;
+uint32_t const Differential::TICK_HISTOGRAM_BINS;
+
 Differential::Differential(const int &argc, char **argv)
   : TimeTriggeredConferenceClientModule(
       argc, argv, "sim-miniature-differential")
-  , m_mutex()
   , m_currentEgoState()
   , m_debug()
-  , m_gpioInA(false)
-  , m_gpioInB(false)
-  , m_gpioInC(false)
-  , m_gpioInD(false)
   , m_deltaTime()
-  , m_leftWheelAngularVelocity(0.0)
-  , m_rightWheelAngularVelocity(0.0)
+  , m_simulationTime(0.0)
+  , m_simulationDuration(0.0)
+  , m_commands()
+  , m_irCalibration()
+  , m_fleet()
+  , m_motorModel()
+  , m_hBridge(false)
+  , m_leftPwmPin(0)
+  , m_rightPwmPin(1)
+  , m_walls()
+  , m_collisionModel()
+  , m_sensors()
+  , m_random()
+  , m_faults()
+  , m_delayLine()
+  , m_commandQueue(COMMAND_QUEUE_SIZE)
+  , m_updates()
+  , m_droppedCommands(0)
+  , m_initialised(false)
+  , m_snapshotFile()
+  , m_snapshotTime(-1.0)
+  , m_tickCounters()
+  , m_messagesIn(0)
+  , m_statisticsTicks(0)
+  , m_statisticsFile()
 {
 }
 
@@ -56,24 +89,35 @@ Differential::~Differential()
 {
 }
 
+/**
+ * Only queues the motor commands received, which the simulation loop 
+ * applies at its next tick, so that it never waits for the receiving.
+ *
+ * The command queue takes a single producer, and this method, called from
+ * the one thread receiving containers, must be the only one pushing to 
+ * it. The fleet and commands it reads are built in setUp and not changed 
+ * after. OpenDaVINCI calls setUp before it delivers containers, but 
+ * nothing is read until setUp has marked the module initialised, so the 
+ * order is not relied on.
+ */
 void Differential::nextContainer(odcore::data::Container &a_c)
 {
-  odcore::base::Lock l(m_mutex);
+  m_messagesIn.fetch_add(1, std::memory_order_relaxed);
+  if (!m_initialised.load(std::memory_order_acquire)) {
+    return;
+  }
 
   int32_t dataType = a_c.getDataType();
-  if (dataType == automotive::miniature::SensorBoardData::ID()) {
-    auto sensorBoardData = 
-        a_c.getData<automotive::miniature::SensorBoardData>();
-    if (m_debug) {
-      std::cout << "[" << getName() << "] Received an SensorBoardData: " 
-          << sensorBoardData.toString() << "." << std::endl;
-    }
-    ConvertBoardDataToSensorReading(sensorBoardData);
-  } else if (dataType == opendlv::proxy::ToggleRequest::ID()) {
+  if (dataType == opendlv::proxy::ToggleRequest::ID()) {
     auto request = a_c.getData<opendlv::proxy::ToggleRequest>();
     uint16_t pin = request.getPin();
     bool state = (request.getState() == opendlv::proxy::ToggleRequest::ToggleState::On);
-    SetMotorControl(pin, state);
+    uint32_t robot;
+    if (GetRobotIndex(a_c.getSenderStamp(), robot)) {
+      CommandUpdate const update = {CommandUpdate::TOGGLE, robot, pin, 
+        state ? 1u : 0u};
+      m_commandQueue.Push(update);
+    }
     if (m_debug) {
       std::cout << "[" << getName() << "] Received a ToggleRequest: "
           << request.toString() << "." << std::endl;
@@ -84,9 +128,41 @@ void Differential::nextContainer(odcore::data::Container &a_c)
       std::cout << "[" << getName() << "] Received a PwmRequest: "
           << request.toString() << "." << std::endl;
     }
+    // A single request gives the wheel as sender stamp, and only drives 
+    // the first robot.
     uint16_t senderStamp = a_c.getSenderStamp();
     uint32_t dutyCycleNs = request.getDutyCycleNs();
-    ConvertPwmToWheelAngularVelocity(senderStamp, dutyCycleNs);
+    if (!m_commands.empty()) {
+      CommandUpdate const update = {CommandUpdate::DUTY_CYCLE, 0, 
+        senderStamp, dutyCycleNs};
+      m_commandQueue.Push(update);
+    }
+  } else if (dataType == opendlv::proxy::PwmRequests::ID()) {
+    auto requests = a_c.getData<opendlv::proxy::PwmRequests>();
+    if (m_debug) {
+      std::cout << "[" << getName() << "] Received a PwmRequests: "
+          << requests.toString() << "." << std::endl;
+    }
+    // The channels are routed to the wheels by pin, as by the PWM proxy, 
+    // and channels on other pins are ignored.
+    uint32_t robot;
+    if (GetRobotIndex(a_c.getSenderStamp(), robot)) {
+      std::vector<uint16_t> pins = requests.getListOfPins();
+      std::vector<uint32_t> dutyCyclesNs = requests.getListOfDutyCyclesNs();
+      for (uint32_t i = 0; i < pins.size() && i < dutyCyclesNs.size(); i++) {
+        uint16_t wheel;
+        if (pins[i] == m_leftPwmPin) {
+          wheel = 1;
+        } else if (pins[i] == m_rightPwmPin) {
+          wheel = 2;
+        } else {
+          continue;
+        }
+        CommandUpdate const update = {CommandUpdate::DUTY_CYCLE, robot, 
+          wheel, dutyCyclesNs[i]};
+        m_commandQueue.Push(update);
+      }
+    }
   }
 }
 
@@ -102,6 +178,401 @@ void Differential::setUp()
   }
 
   m_deltaTime = 1 / getFrequency();
+
+  // In lock-step runs (odsupercomponent --managed=simulation) the module 
+  // stops after this many seconds of simulated time, zero runs until 
+  // stopped.
+  m_simulationDuration = kv.getOptionalValue<double>(
+      "sim-miniature-differential.simulationDuration", valueFound);
+  if (!valueFound) {
+    m_simulationDuration = 0.0;
+  }
+  m_simulationTime = 0.0;
+
+  // The timing of the ticks is sent as TickStatistics this often, in s, 
+  // and can also be written as CSV. Zero sends nothing.
+  double statisticsInterval = kv.getOptionalValue<double>(
+      "sim-miniature-differential.statisticsInterval", valueFound);
+  if (!valueFound) {
+    statisticsInterval = 1.0;
+  }
+  m_statisticsTicks = static_cast<uint32_t>(
+      std::max(std::round(statisticsInterval / m_deltaTime), 0.0));
+  m_tickCounters.reset(new common::miniature::TickCounters(m_deltaTime,
+      TICK_HISTOGRAM_BINS));
+  std::string const statisticsFile = kv.getOptionalValue<std::string>(
+      "sim-miniature-differential.statisticsFile", valueFound);
+  if (valueFound && m_statisticsTicks > 0) {
+    m_statisticsFile.open(statisticsFile.c_str());
+    if (m_statisticsFile.is_open()) {
+      common::miniature::TickCounters::WriteCsvHeader(m_statisticsFile);
+    } else {
+      std::cerr << "[" << getName() << "] Could not open " 
+          << statisticsFile << "." << std::endl;
+    }
+  }
+
+  // The drive is integrated at the integration frequency inside each tick,
+  // with the integrator euler, midpoint or rk4.
+  double wheelRadius = kv.getOptionalValue<double>(
+      "sim-miniature-differential.wheelRadius", valueFound);
+  if (!valueFound) {
+    wheelRadius = 0.03;
+  }
+  double trackWidth = kv.getOptionalValue<double>(
+      "sim-miniature-differential.trackWidth", valueFound);
+  if (!valueFound) {
+    trackWidth = 0.12;
+  }
+  double integrationFrequency = kv.getOptionalValue<double>(
+      "sim-miniature-differential.integrationFrequency", valueFound);
+  if (!valueFound || !(integrationFrequency > 0.0)) {
+    integrationFrequency = 1000.0;
+  }
+  DifferentialDrive::Integrator integrator = DifferentialDrive::RK4;
+  std::string const integratorName = kv.getOptionalValue<std::string>(
+      "sim-miniature-differential.integrator", valueFound);
+  if (valueFound 
+      && !DifferentialDrive::ParseIntegrator(integratorName, integrator)) {
+    std::cerr << "[" << getName() << "] Unknown integrator " 
+        << integratorName << ", using rk4." << std::endl;
+  }
+
+  // All robots are simulated together. Robot i is driven by the modules 
+  // started with --id=i+1 and publishes its LPS state with frame id i. The 
+  // robots start side by side, facing along x, with the first one at the 
+  // origin.
+  uint32_t fleetSize = kv.getOptionalValue<uint32_t>(
+      "sim-miniature-differential.fleetSize", valueFound);
+  if (!valueFound || fleetSize == 0) {
+    fleetSize = 1;
+  }
+  double fleetSpacing = kv.getOptionalValue<double>(
+      "sim-miniature-differential.fleetSpacing", valueFound);
+  if (!valueFound) {
+    fleetSpacing = 0.3;
+  }
+  m_fleet.reset(new Fleet(fleetSize, wheelRadius, trackWidth, integrator, 
+        1.0 / integrationFrequency));
+  for (uint32_t i = 0; i < fleetSize; i++) {
+    DifferentialPose pose = {0.0, i * fleetSpacing, 0.0};
+    m_fleet->SetPose(i, pose);
+  }
+
+  // The motors are servos driven by 1 to 2 ms pulses by default, or driven
+  // through an H-bridge where the pulse only sets the speed.
+  std::string const motorInput = kv.getOptionalValue<std::string>(
+      "sim-miniature-differential.motorInput", valueFound);
+  m_hBridge = (valueFound && motorInput == "hbridge");
+  if (valueFound && !m_hBridge && motorInput != "servo") {
+    std::cerr << "[" << getName() << "] Unknown motor input " << motorInput 
+        << ", using servo." << std::endl;
+  }
+  // The PWM pins of the left and right wheel, as given to the PWM proxy.
+  m_leftPwmPin = kv.getOptionalValue<uint16_t>(
+      "sim-miniature-differential.leftPwmPin", valueFound);
+  if (!valueFound) {
+    m_leftPwmPin = 0;
+  }
+  m_rightPwmPin = kv.getOptionalValue<uint16_t>(
+      "sim-miniature-differential.rightPwmPin", valueFound);
+  if (!valueFound) {
+    m_rightPwmPin = 1;
+  }
+  uint32_t minPulseNs = kv.getOptionalValue<uint32_t>(
+      "sim-miniature-differential.minPulseNs", valueFound);
+  if (!valueFound) {
+    minPulseNs = m_hBridge ? 25000 : 1000000;
+  }
+  uint32_t neutralPulseNs = kv.getOptionalValue<uint32_t>(
+      "sim-miniature-differential.neutralPulseNs", valueFound);
+  if (!valueFound) {
+    neutralPulseNs = m_hBridge ? minPulseNs : 1500000;
+  }
+  uint32_t maxPulseNs = kv.getOptionalValue<uint32_t>(
+      "sim-miniature-differential.maxPulseNs", valueFound);
+  if (!valueFound) {
+    maxPulseNs = m_hBridge ? 50000 : 2000000;
+  }
+  double motorDeadband = kv.getOptionalValue<double>(
+      "sim-miniature-differential.motorDeadband", valueFound);
+  if (!valueFound) {
+    motorDeadband = 0.0;
+  }
+  double motorExponent = kv.getOptionalValue<double>(
+      "sim-miniature-differential.motorExponent", valueFound);
+  if (!valueFound) {
+    motorExponent = 1.0;
+  }
+  double maxWheelAngularVelocity = kv.getOptionalValue<double>(
+      "sim-miniature-differential.maxWheelAngularVelocity", valueFound);
+  if (!valueFound) {
+    maxWheelAngularVelocity = 10.0;
+  }
+  double motorTimeConstant = kv.getOptionalValue<double>(
+      "sim-miniature-differential.motorTimeConstant", valueFound);
+  if (!valueFound) {
+    motorTimeConstant = 0.0;
+  }
+  m_motorModel.reset(new MotorModel(minPulseNs, neutralPulseNs, maxPulseNs,
+        motorDeadband, motorExponent, maxWheelAngularVelocity, 
+        motorTimeConstant));
+  m_fleet->SetTimeConstant(m_motorModel->GetTimeConstant());
+
+  MotorCommand const stopped = {false, false, false, false, 0, 0};
+  m_commands.assign(fleetSize, stopped);
+
+  // The IR sensors use a voltage to distance curve given in the same form 
+  // as for the analog proxy, so that the same calibration maps simulated 
+  // voltages back to the simulated distances. Without a curve the linear 
+  // model is used.
+  std::vector<float> voltages = {0.0f, 1.8f};
+  std::vector<float> distances = {0.0f, 4.0f};
+  std::string const voltagesString = kv.getOptionalValue<std::string>(
+      "sim-miniature-differential.calibrationVoltages", valueFound);
+  if (valueFound) {
+    std::string const distancesString = kv.getValue<std::string>(
+        "sim-miniature-differential.calibrationDistances");
+    voltages.clear();
+    distances.clear();
+    for (std::string const &str : 
+        odcore::strings::StringToolbox::split(voltagesString, ',')) {
+      voltages.push_back(std::stof(str));
+    }
+    for (std::string const &str : 
+        odcore::strings::StringToolbox::split(distancesString, ',')) {
+      distances.push_back(std::stof(str));
+    }
+  }
+  if (voltages.size() == distances.size() && voltages.size() >= 2) {
+    for (uint32_t i = 0; i < voltages.size(); i++) {
+      m_irCalibration.push_back(std::make_pair(distances[i], voltages[i]));
+    }
+    std::sort(m_irCalibration.begin(), m_irCalibration.end());
+  } else {
+    std::cerr << "[" << getName() 
+        << "] Number of calibration voltages and distances do not match." 
+        << std::endl;
+    m_irCalibration.push_back(std::make_pair(0.0, 0.0f));
+    m_irCalibration.push_back(std::make_pair(4.0, 1.8f));
+  }
+
+  // The walls are given as segments in m, and can also be read from the 
+  // polygons of the scenario, which is scaled as the simulated positions.
+  std::string const walls = kv.getOptionalValue<std::string>(
+      "sim-miniature-differential.walls", valueFound);
+  if (valueFound) {
+    ReadWalls(walls);
+  }
+  bool useScenario = kv.getOptionalValue<bool>(
+      "sim-miniature-differential.useScenario", valueFound);
+  if (valueFound && useScenario) {
+    double scenarioScale = kv.getOptionalValue<double>(
+        "sim-miniature-differential.scenarioScale", valueFound);
+    if (!valueFound) {
+      scenarioScale = 0.1;
+    }
+    ReadScenarioWalls(kv.getValue<std::string>("global.scenario"), 
+        scenarioScale);
+  }
+  double gridCellSize = kv.getOptionalValue<double>(
+      "sim-miniature-differential.gridCellSize", valueFound);
+  if (!valueFound || !(gridCellSize > 0.0)) {
+    gridCellSize = 0.25;
+  }
+  m_walls.Build(gridCellSize);
+
+  // The robots are circles that either stop or slide along the walls they
+  // run into, and stop when they run into each other. The collisions are 
+  // checked at each substep.
+  std::string const collisionResponse = kv.getOptionalValue<std::string>(
+      "sim-miniature-differential.collisionResponse", valueFound);
+  CollisionModel::Response response = CollisionModel::STOP;
+  bool collisions = true;
+  if (valueFound && collisionResponse == "none") {
+    collisions = false;
+  } else if (valueFound 
+      && !CollisionModel::ParseResponse(collisionResponse, response)) {
+    std::cerr << "[" << getName() << "] Unknown collision response " 
+        << collisionResponse << ", using stop." << std::endl;
+  }
+  double robotRadius = kv.getOptionalValue<double>(
+      "sim-miniature-differential.robotRadius", valueFound);
+  if (!valueFound) {
+    robotRadius = 0.1;
+  }
+  bool robotCollisions = kv.getOptionalValue<bool>(
+      "sim-miniature-differential.robotCollisions", valueFound);
+  if (!valueFound) {
+    robotCollisions = true;
+  }
+  if (collisions) {
+    m_collisionModel.reset(new CollisionModel(m_walls, robotRadius, response,
+          robotCollisions));
+    m_fleet->SetCollisionModel(m_collisionModel.get());
+  }
+
+  // The sensors are configured as for odsimirus, with the angles in 
+  // degrees and the lengths in m. The beam is cast as a number of rays 
+  // over the field of view.
+  uint32_t numberOfSensors = kv.getOptionalValue<uint32_t>(
+      "sim-miniature-differential.numberOfSensors", valueFound);
+  if (!valueFound) {
+    numberOfSensors = 0;
+  }
+  double const degreesToRadians = M_PI / 180.0;
+  for (uint32_t i = 0; i < numberOfSensors; i++) {
+    std::string const prefix = "sim-miniature-differential.sensor" 
+        + std::to_string(i) + ".";
+    uint32_t const id = kv.getValue<uint32_t>(prefix + "id");
+    double const rotZ = kv.getValue<double>(prefix + "rotZ");
+    std::vector<std::string> translation = 
+        odcore::strings::StringToolbox::split(
+            kv.getValue<std::string>(prefix + "translation"), ',');
+    double const angleFov = kv.getValue<double>(prefix + "angleFOV");
+    double const distanceFov = kv.getValue<double>(prefix + "distanceFOV");
+    uint32_t rays = kv.getOptionalValue<uint32_t>(prefix + "rays", 
+        valueFound);
+    if (!valueFound) {
+      rays = 1 + static_cast<uint32_t>(std::ceil(angleFov / 2.5));
+    }
+    double noise = kv.getOptionalValue<double>(prefix + "noise", valueFound);
+    if (!valueFound) {
+      noise = 0.0;
+    }
+    if (translation.size() != 2) {
+      std::cerr << "[" << getName() << "] Sensor " << i 
+          << " needs a translation as x,y." << std::endl;
+      continue;
+    }
+    m_sensors.push_back(RangeSensor(id, std::stod(translation[0]), 
+          std::stod(translation[1]), rotZ * degreesToRadians, 
+          angleFov * degreesToRadians, distanceFov, rays, noise));
+  }
+
+  // The measurements sent are made imperfect by the faults. All noise and
+  // faults are drawn from one generator, so that a seed repeats a run.
+  uint32_t seed = kv.getOptionalValue<uint32_t>(
+      "sim-miniature-differential.seed", valueFound);
+  if (!valueFound) {
+    seed = std::mt19937::default_seed;
+  }
+  m_random.seed(seed);
+  double lpsPositionNoise = kv.getOptionalValue<double>(
+      "sim-miniature-differential.lpsPositionNoise", valueFound);
+  if (!valueFound) {
+    lpsPositionNoise = 0.0;
+  }
+  double lpsYawNoise = kv.getOptionalValue<double>(
+      "sim-miniature-differential.lpsYawNoise", valueFound);
+  if (!valueFound) {
+    lpsYawNoise = 0.0;
+  }
+  double dropout = kv.getOptionalValue<double>(
+      "sim-miniature-differential.dropout", valueFound);
+  if (!valueFound) {
+    dropout = 0.0;
+  }
+  double latency = kv.getOptionalValue<double>(
+      "sim-miniature-differential.latency", valueFound);
+  if (!valueFound) {
+    latency = 0.0;
+  }
+  double latencyJitter = kv.getOptionalValue<double>(
+      "sim-miniature-differential.latencyJitter", valueFound);
+  if (!valueFound) {
+    latencyJitter = 0.0;
+  }
+  double stuckProbability = kv.getOptionalValue<double>(
+      "sim-miniature-differential.stuckProbability", valueFound);
+  if (!valueFound) {
+    stuckProbability = 0.0;
+  }
+  double stuckDuration = kv.getOptionalValue<double>(
+      "sim-miniature-differential.stuckDuration", valueFound);
+  if (!valueFound) {
+    stuckDuration = 1.0;
+  }
+  m_faults.reset(new FaultModel(lpsPositionNoise, lpsYawNoise, dropout, 
+        latency, latencyJitter, stuckProbability, stuckDuration));
+
+  // The world can be saved once at a point in simulated time, and a run 
+  // can start from a saved world instead. A run forked from a saved world 
+  // can be given a new seed, or else it repeats the original run.
+  m_snapshotFile = kv.getOptionalValue<std::string>(
+      "sim-miniature-differential.snapshotFile", valueFound);
+  if (valueFound) {
+    m_snapshotTime = kv.getValue<double>(
+        "sim-miniature-differential.snapshotTime");
+  }
+  std::string const restoreFile = kv.getOptionalValue<std::string>(
+      "sim-miniature-differential.restoreSnapshot", valueFound);
+  if (valueFound) {
+    if (RestoreSnapshot(restoreFile)) {
+      std::cout << "[" << getName() << "] Restored the world at " 
+          << m_simulationTime << " s from " << restoreFile << "." 
+          << std::endl;
+      uint32_t const forkSeed = kv.getOptionalValue<uint32_t>(
+          "sim-miniature-differential.forkSeed", valueFound);
+      if (valueFound) {
+        m_random.seed(forkSeed);
+      }
+    } else {
+      std::cerr << "[" << getName() << "] Could not restore the world from "
+          << restoreFile << ", starting over." << std::endl;
+    }
+  }
+
+  std::cout << "[" << getName() << "] Simulating " << m_sensors.size() 
+      << " sensors against " << m_walls.GetSegmentCount() << " walls." 
+      << std::endl;
+
+  m_initialised.store(true, std::memory_order_release);
+}
+
+/**
+ * Adds walls given as x1,y1,x2,y2 in m, separated by semicolons.
+ */
+void Differential::ReadWalls(std::string const &a_walls)
+{
+  for (std::string const &wallString : 
+      odcore::strings::StringToolbox::split(a_walls, ';')) {
+    std::vector<std::string> coordinates = 
+        odcore::strings::StringToolbox::split(wallString, ',');
+    if (coordinates.size() != 4) {
+      std::cerr << "[" << getName() << "] Ignoring wall '" << wallString 
+          << "', it needs x1,y1,x2,y2." << std::endl;
+      continue;
+    }
+    WallSegment const wall = {std::stod(coordinates[0]), 
+      std::stod(coordinates[1]), std::stod(coordinates[2]), 
+      std::stod(coordinates[3])};
+    m_walls.AddSegment(wall);
+  }
+}
+
+/**
+ * Adds the edges of all polygons in a scenario (.scnx) as walls.
+ */
+void Differential::ReadScenarioWalls(std::string const &a_scenario, 
+    double a_scale)
+{
+  odcore::io::URL const url(a_scenario);
+  opendlv::data::scenario::SCNXArchive &archive = 
+      opendlv::data::scenario::SCNXArchiveFactory::getInstance()
+      .getSCNXArchive(url);
+  std::vector<opendlv::data::scenario::Polygon*> polygons = 
+      archive.getListOfPolygons();
+  for (opendlv::data::scenario::Polygon *polygon : polygons) {
+    std::vector<double> x;
+    std::vector<double> y;
+    for (opendlv::data::scenario::Vertex3 const &vertex : 
+        polygon->getListOfVertices()) {
+      x.push_back(vertex.getX() * a_scale);
+      y.push_back(vertex.getY() * a_scale);
+    }
+    m_walls.AddPolygon(x, y);
+  }
 }
 
 void Differential::tearDown()
@@ -112,183 +583,429 @@ odcore::data::dmcp::ModuleExitCodeMessage::ModuleExitCode Differential::body()
 {
   while (getModuleStateAndWaitForRemainingTimeInTimeslice() == 
       odcore::data::dmcp::ModuleStateMessage::RUNNING) {
+    m_tickCounters->BeginTick();
   
-    odcore::base::Lock l(m_mutex);
+    ApplyCommands();
   
-    opendlv::data::environment::Point3 prevPosition = 
-      m_currentEgoState.getPosition();
-    opendlv::data::environment::Point3 prevRotation = 
-      m_currentEgoState.getRotation();
-    opendlv::data::environment::Point3 prevVelocity = 
-      m_currentEgoState.getVelocity();
-
-    double prevVelX = prevVelocity.getX();
-    double prevVelY = prevVelocity.getY();
-    
-    // The division is needed due to a scaling problem, in order to convert into
-    // meters. In your code below, everything will be meters.
-    double prevPosX = prevPosition.getX() / 10.0;
-    double prevPosY = prevPosition.getY() / 10.0;
-
-    double prevYaw = atan2(prevRotation.getY(), prevRotation.getX());
-    // NOTE: Do not change the code above.
+    // The commands received since the last tick are applied together, so 
+    // that the result does not depend on the order in which the motor 
+    // direction and duty cycles arrived.
+    uint32_t const fleetSize = m_fleet->GetSize();
+    for (uint32_t i = 0; i < fleetSize; i++) {
+      MotorCommand const &command = m_commands[i];
+      double const leftWheelAngularVelocity = ConvertPwmToWheelAngularVelocity(
+          command.leftDutyCycleNs, 
+          GetMotorDirection(command.gpioInB, command.gpioInA));
+      double const rightWheelAngularVelocity = ConvertPwmToWheelAngularVelocity(
+          command.rightDutyCycleNs, 
+          GetMotorDirection(command.gpioInC, command.gpioInD));
+      m_fleet->SetWheelTargets(i, leftWheelAngularVelocity, 
+          rightWheelAngularVelocity);
+    }
 
+    // The tick is integrated in substeps for all robots at once, with the 
+    // wheel speeds following the motor lag.
+    m_fleet->Step(m_deltaTime);
 
+    for (uint32_t i = 0; i < fleetSize; i++) {
+      DifferentialPose const pose = m_fleet->GetPose(i);
 
+      // Due to a simulation scaling problem, the position is scaled. 
+      double posX = pose.x * 10.0;
+      double posY = pose.y * 10.0;
+      double yaw = pose.yaw;
 
-    ///// TODO: Add kinematic equations below. Use the prepared class global
-    ///// variables for wheel speeds (already saved, see the below method).
+      // The EgoState, which odcockpit shows, follows the first robot only.
+      if (i == 0) {
+        opendlv::data::environment::Point3 prevVelocity = 
+          m_currentEgoState.getVelocity();
 
-    double velX = 0.0; // Placeholder.
-    double velY = 0.0; // Placeholder.
-    //double yawRate = 0.0; // Placeholder.
-   
-    std::cout << "TODO: Add kinematic equations." << std::endl;
-    ///// Kinematic equations above.
+        double velX = m_fleet->GetLinearVelocity(i) * cos(yaw);
+        double velY = m_fleet->GetLinearVelocity(i) * sin(yaw);
 
+        double posZ = 0.0;
+        double velZ = 0.0;
+        double accZ = 0.0;
 
+        double accX = (velX - prevVelocity.getX()) / m_deltaTime;
+        double accY = (velY - prevVelocity.getY()) / m_deltaTime;
 
+        opendlv::data::environment::Point3 position(posX, posY, posZ);
+        opendlv::data::environment::Point3 rotation(1.0, 0.0, 0.0);
+        opendlv::data::environment::Point3 velocity(velX, velY, velZ);
+        opendlv::data::environment::Point3 acceleration(accX, accY, accZ);
 
-    ///// TODO: Integrate simulation below. The time step is already saved in
-    ///// a global variable.
+        rotation.rotateZ(yaw);
+        rotation.normalize();
 
-    double posX = prevPosX; // Placeholder.
-    double posY = prevPosY; // Placeholder.
-    double yaw = prevYaw; // Placeholder.
-    
-    std::cout << "TODO: Integrate simulation." << std::endl;
-    ///// Integration above.
+        opendlv::data::environment::EgoState egoState(position, rotation, 
+            velocity, acceleration);
 
+        m_currentEgoState = egoState;
 
+        odcore::data::Container c(egoState);
+        Send(c);
+      }
 
-    
+      // The sensors are simulated for the first robot, which the readings
+      // have always been for.
+      if (i == 0) {
+        SimulateSensors(pose);
+      }
 
-    // Due to a simulation scaling problem, the position is scaled. 
-    // NOTE: Do not change the code below.
-    posX = posX * 10.0;
-    posY = posY * 10.0;
+      // Simulate LPS, with its measurement noise.
+      DifferentialPose lpsPose = pose;
+      m_faults->AddPoseNoise(lpsPose, m_random);
+      opendlv::model::Cartesian3 lpsPosition(static_cast<float>(lpsPose.x * 10.0), static_cast<float>(lpsPose.y * 10.0), 0.0f);
+      opendlv::model::Cartesian3 lpsOrientation(0.0f, 0.0f, static_cast<float>(lpsPose.yaw));
+      opendlv::model::State lpsState(lpsPosition, lpsOrientation, i);
+      odcore::data::Container lpsContainer(lpsState);
+      Publish(lpsContainer);
+    }
 
-    double posZ = 0.0;
-    double velZ = 0.0;
-    double accZ = 0.0;
+    m_simulationTime += m_deltaTime;
+
+    if (!m_snapshotFile.empty() && m_snapshotTime >= 0.0 
+        && m_simulationTime >= m_snapshotTime - m_deltaTime / 2.0) {
+      if (SaveSnapshot(m_snapshotFile)) {
+        std::cout << "[" << getName() << "] Saved the world at " 
+            << m_simulationTime << " s to " << m_snapshotFile << "." 
+            << std::endl;
+      } else {
+        std::cerr << "[" << getName() << "] Could not save the world to " 
+            << m_snapshotFile << "." << std::endl;
+      }
+      m_snapshotTime = -1.0;
+    }
 
-    double accX = (velX - prevVelX) / m_deltaTime;
-    double accY = (velY - prevVelY) / m_deltaTime;
+    // Delayed measurements are sent at the first tick they are due.
+    std::vector<odcore::data::Container> due;
+    m_delayLine.PopDue(m_simulationTime, due);
+    for (odcore::data::Container &c : due) {
+      Send(c);
+    }
 
-    opendlv::data::environment::Point3 position(posX, posY, posZ);
-    opendlv::data::environment::Point3 rotation(1.0, 0.0, 0.0);
-    opendlv::data::environment::Point3 velocity(velX, velY, velZ);
-    opendlv::data::environment::Point3 acceleration(accX, accY, accZ);
+    m_tickCounters->EndTick();
+    m_tickCounters->AddMessagesIn(
+        m_messagesIn.exchange(0, std::memory_order_relaxed));
+    if (m_statisticsTicks > 0 
+        && m_tickCounters->GetTicks() >= m_statisticsTicks) {
+      ReportTickCounters();
+    }
 
+    if (m_simulationDuration > 0.0 
+        && m_simulationTime >= m_simulationDuration - m_deltaTime / 2.0) {
+      for (uint32_t i = 0; i < fleetSize; i++) {
+        DifferentialPose const pose = m_fleet->GetPose(i);
+        std::cout << "[" << getName() << "] Simulated " << m_simulationTime 
+            << " s, final pose of robot " << i << ": " << pose.x << " " 
+            << pose.y << " " << pose.yaw << "." << std::endl;
+        if (m_collisionModel) {
+          std::cout << "[" << getName() << "] Robot " << i << " ran into " 
+              << m_collisionModel->GetWallCollisions(i) << " walls and " 
+              << m_collisionModel->GetRobotCollisions(i) << " robots." 
+              << std::endl;
+        }
+      }
+      break;
+    }
+  }
 
-    rotation.rotateZ(yaw);
-    rotation.normalize();
+  return odcore::data::dmcp::ModuleExitCodeMessage::OKAY;
+}
 
-    opendlv::data::environment::EgoState egoState(position, rotation, velocity,
-        acceleration);
+/**
+ * Saves the robots, their motor commands, the simulated time and the 
+ * random generator. Measurements not yet sent, and the collision and 
+ * stuck sensor state, are not saved.
+ */
+bool Differential::SaveSnapshot(std::string const &a_filename)
+{
+  WorldSnapshot snapshot;
+  snapshot.simulationTime = m_simulationTime;
+  snapshot.SetRandom(m_random);
+  for (uint32_t i = 0; i < m_fleet->GetSize(); i++) {
+    DifferentialPose const pose = m_fleet->GetPose(i);
+    MotorCommand const &command = m_commands[i];
+    RobotSnapshot robot;
+    robot.x = pose.x;
+    robot.y = pose.y;
+    robot.yaw = pose.yaw;
+    m_fleet->GetWheelAngularVelocities(i, robot.leftWheel, robot.rightWheel);
+    m_fleet->GetWheelTargets(i, robot.leftTarget, robot.rightTarget);
+    robot.leftDutyCycleNs = command.leftDutyCycleNs;
+    robot.rightDutyCycleNs = command.rightDutyCycleNs;
+    robot.gpio = static_cast<uint8_t>((command.gpioInA ? 1 : 0) 
+        | (command.gpioInB ? 2 : 0) | (command.gpioInC ? 4 : 0) 
+        | (command.gpioInD ? 8 : 0));
+    snapshot.robots.push_back(robot);
+  }
+  return snapshot.Save(a_filename);
+}
 
-    m_currentEgoState = egoState;
+/**
+ * Restores a saved world with as many robots as simulated.
+ */
+bool Differential::RestoreSnapshot(std::string const &a_filename)
+{
+  WorldSnapshot snapshot;
+  if (!snapshot.Load(a_filename) 
+      || snapshot.robots.size() != m_fleet->GetSize()
+      || !snapshot.GetRandom(m_random)) {
+    return false;
+  }
+  m_simulationTime = snapshot.simulationTime;
+  for (uint32_t i = 0; i < snapshot.robots.size(); i++) {
+    RobotSnapshot const &robot = snapshot.robots[i];
+    DifferentialPose const pose = {robot.x, robot.y, robot.yaw};
+    m_fleet->SetPose(i, pose);
+    m_fleet->SetWheelAngularVelocities(i, robot.leftWheel, robot.rightWheel);
+    m_fleet->SetWheelTargets(i, robot.leftTarget, robot.rightTarget);
+    MotorCommand &command = m_commands[i];
+    command.leftDutyCycleNs = robot.leftDutyCycleNs;
+    command.rightDutyCycleNs = robot.rightDutyCycleNs;
+    command.gpioInA = (robot.gpio & 1) != 0;
+    command.gpioInB = (robot.gpio & 2) != 0;
+    command.gpioInC = (robot.gpio & 4) != 0;
+    command.gpioInD = (robot.gpio & 8) != 0;
+  }
+  return true;
+}
 
-    odcore::data::Container c(egoState);
-    getConference().send(c);
+/**
+ * Applies the motor commands queued since the last tick, in the order they
+ * were received.
+ */
+void Differential::ApplyCommands()
+{
+  m_updates.clear();
+  m_commandQueue.Drain(m_updates);
+  for (CommandUpdate const &update : m_updates) {
+    if (update.kind == CommandUpdate::DUTY_CYCLE) {
+      SetDutyCycle(update.robot, update.channel, update.value);
+    } else {
+      SetMotorControl(update.robot, update.channel, update.value != 0);
+    }
+  }
 
-    // Simulate LPS.
-    opendlv::model::Cartesian3 lpsPosition(static_cast<float>(posX), static_cast<float>(posY), 0.0f);
-    opendlv::model::Cartesian3 lpsOrientation(0.0f, 0.0f, static_cast<float>(yaw));
-    opendlv::model::State lpsState(lpsPosition, lpsOrientation, 0);
-    odcore::data::Container lpsContainer(lpsState);
-    getConference().send(lpsContainer);
+  uint32_t const dropped = m_commandQueue.GetDropped();
+  if (dropped != m_droppedCommands) {
+    std::cerr << "[" << getName() << "] Dropped " 
+        << dropped - m_droppedCommands 
+        << " motor commands, the queue was full." << std::endl;
+    m_droppedCommands = dropped;
   }
+}
 
-  return odcore::data::dmcp::ModuleExitCodeMessage::OKAY;
+/**
+ * Maps the sender of a command to a robot. With a single robot every sender
+ * drives it, as before there were several.
+ */
+bool Differential::GetRobotIndex(uint32_t a_senderStamp, uint32_t &a_robot) 
+    const
+{
+  uint32_t const fleetSize = static_cast<uint32_t>(m_commands.size());
+  if (fleetSize == 1) {
+    a_robot = 0;
+    return true;
+  }
+  if (a_senderStamp == 0 || a_senderStamp > fleetSize) {
+    return false;
+  }
+  a_robot = a_senderStamp - 1;
+  return true;
 }
 
-void Differential::ConvertPwmToWheelAngularVelocity(uint16_t a_senderStamp, 
-    uint32_t a_dutyCycleNs)
+/**
+ * Converts the pulse width of a wheel to the angular velocity it settles 
+ * at, in the given direction.
+ */
+double Differential::ConvertPwmToWheelAngularVelocity(uint32_t a_pulseNs,
+    int32_t a_direction) const
 {
-  int32_t const minDutyCycleNs = 25000; 
-  int32_t const maxDutyCycleNs = 50000; 
+  return m_motorModel->GetAngularVelocity(
+      m_motorModel->GetCommand(a_pulseNs) * a_direction);
+}
 
-  double const maxAngularVelocity = 10.0;
+/**
+ * Returns the direction a wheel is driven in by the two inputs of an 
+ * H-bridge, which servo motors do not have.
+ */
+int32_t Differential::GetMotorDirection(bool a_forward, bool a_reverse) const
+{
+  if (!m_hBridge) {
+    return 1;
+  }
+  if (a_forward && !a_reverse) {
+    return 1;
+  } else if (!a_forward && a_reverse) {
+    return -1;
+  }
+  return 0;
+}
 
-  a_dutyCycleNs = (a_dutyCycleNs < minDutyCycleNs) ? minDutyCycleNs : a_dutyCycleNs; 
-  a_dutyCycleNs = (a_dutyCycleNs > maxDutyCycleNs) ? maxDutyCycleNs : a_dutyCycleNs; 
-  
-  double wheelAngularVelocity = maxAngularVelocity * 
-    (a_dutyCycleNs - minDutyCycleNs) / 
-    static_cast<double>(maxDutyCycleNs - minDutyCycleNs); 
-      
-  if (a_senderStamp == 1) {
-    if (m_gpioInA && !m_gpioInB) {
-      // Clockwise
-      m_leftWheelAngularVelocity = -wheelAngularVelocity;
-    } else if (!m_gpioInA && m_gpioInB) {
-      // Counter clockwise
-      m_leftWheelAngularVelocity = wheelAngularVelocity;
-    } else {
-      m_leftWheelAngularVelocity = 0.0;
-    }
-  } else if (a_senderStamp == 2) {
-    if (m_gpioInC && !m_gpioInD) {
-      // Clockwise
-      m_rightWheelAngularVelocity = wheelAngularVelocity;
-    } else if (!m_gpioInC && m_gpioInD) {
-      // Counter clockwise
-      m_rightWheelAngularVelocity = -wheelAngularVelocity;
-    } else {
-      m_rightWheelAngularVelocity = 0.0f;
-    }
+/**
+ * Keeps the duty cycle of a wheel of a robot, which is converted at the 
+ * next tick.
+ */
+void Differential::SetDutyCycle(uint32_t a_robot, uint16_t a_wheel, 
+    uint32_t a_dutyCycleNs)
+{
+  if (a_wheel == 1) {
+    m_commands[a_robot].leftDutyCycleNs = a_dutyCycleNs;
+  } else if (a_wheel == 2) {
+    m_commands[a_robot].rightDutyCycleNs = a_dutyCycleNs;
   }
 }
 
-void Differential::ConvertBoardDataToSensorReading(
-  automotive::miniature::SensorBoardData const &a_sensorBoardData)
+/**
+ * Measures the simulated sensors of a robot, and sends the readings as
+ * odsimirus did. Nothing within range reads as the maximum calibrated 
+ * distance on the IR inputs. In the proximity readings it reads as the 
+ * range of the sensor with zero confidence, as no echo from the sonar 
+ * proxy, so that consumers treat the simulation and the robot alike.
+ */
+void Differential::SimulateSensors(DifferentialPose const &a_pose)
 {
-  std::map<uint32_t, double> mapOfDistances = 
-      a_sensorBoardData.getMapOfDistances();
+  if (m_sensors.empty()) {
+    return;
+  }
+
+  double const maxDistance = m_irCalibration.back().first;
+
+  // The IR sensors are sent together, as by the analog proxy.
+  std::vector<uint16_t> pins;
+  std::vector<float> voltages;
+  std::vector<float> distances;
  
-  double const maxDistance = 4.0f * 10;
-
-  for (auto distanceReading : mapOfDistances) {
-    uint32_t sensorId = distanceReading.first;
-    double distance = distanceReading.second;
-    
-    float voltage = 1.8f;
-    if (distance > 0.0 && distance < maxDistance) {
-      voltage = 1.8f * static_cast<float>(distance / maxDistance);
+  for (uint32_t i = 0; i < m_sensors.size(); i++) {
+    RangeSensor const &sensor = m_sensors[i];
+    uint32_t sensorId = sensor.GetId();
+    double distance = 0.0;
+    bool found = sensor.Measure(m_walls, a_pose, m_random, distance);
+    m_faults->ApplyStuck(i, m_simulationTime, found, distance, m_random);
+
+    double irDistance = found ? distance : maxDistance;
+    if (irDistance > maxDistance) {
+      irDistance = maxDistance;
     }
+    irDistance = std::max(irDistance, m_irCalibration.front().first);
+    float voltage = ConvertDistanceToVoltage(irDistance);
 
-    opendlv::proxy::AnalogReading analogReading(sensorId, voltage);
-    odcore::data::Container analogContainer(analogReading);
-    getConference().send(analogContainer);
-    
-    opendlv::proxy::ProximityReading proximityReading(distance);
+    pins.push_back(static_cast<uint16_t>(sensorId));
+    voltages.push_back(voltage);
+    distances.push_back(static_cast<float>(irDistance));
+
+    // The proximity is scaled as the simulated positions, see body().
+    double const proximity = (found ? distance : sensor.GetRange()) * 10.0;
+    opendlv::proxy::ProximityReading proximityReading(proximity, 
+        static_cast<uint16_t>(sensorId), found ? 1.0f : 0.0f);
     odcore::data::Container proximityContainer(proximityReading);
-    getConference().send(proximityContainer);
+    Publish(proximityContainer);
+  }
+
+  opendlv::proxy::AnalogReadings analogReadings;
+  analogReadings.setListOfPins(pins);
+  analogReadings.setListOfVoltages(voltages);
+  analogReadings.setListOfDistances(distances);
+  odcore::data::Container analogContainer(analogReadings);
+  Publish(analogContainer);
+}
+
+/**
+ * Sends a simulated measurement through the faults, either now, later or
+ * not at all.
+ */
+void Differential::Publish(odcore::data::Container &a_container)
+{
+  if (m_faults->IsDropped(m_random)) {
+    return;
+  }
+  double const delay = m_faults->GetDelay(m_random);
+  if (delay > 0.0) {
+    m_delayLine.Push(m_simulationTime + delay, a_container);
+  } else {
+    Send(a_container);
+  }
+}
+
+void Differential::Send(odcore::data::Container &a_container)
+{
+  getConference().send(a_container);
+  m_tickCounters->AddMessagesOut(1);
+}
+
+/**
+ * Sends the timing of the ticks since the last report, writes it to the 
+ * CSV file if any, and starts counting again.
+ */
+void Differential::ReportTickCounters()
+{
+  opendlv::system::TickStatistics statistics(m_tickCounters->GetTicks(), 
+      m_tickCounters->GetOverruns(), m_tickCounters->GetMessagesIn(), 
+      m_tickCounters->GetMessagesOut(), 
+      static_cast<float>(m_tickCounters->GetMeanComputeTime()), 
+      static_cast<float>(m_tickCounters->GetMaxComputeTime()), 
+      static_cast<float>(m_tickCounters->GetMeanWaitTime()), 
+      static_cast<float>(m_tickCounters->GetBinWidth()), 
+      m_tickCounters->GetComputeTimes(), m_tickCounters->GetWaitTimes());
+  odcore::data::Container c(statistics);
+  getConference().send(c);
+
+  if (m_statisticsFile.is_open()) {
+    m_tickCounters->WriteCsv(m_statisticsFile, m_simulationTime);
+  }
+  if (m_tickCounters->GetOverruns() > 0) {
+    std::cerr << "[" << getName() << "] " << m_tickCounters->GetOverruns() 
+        << " of " << m_tickCounters->GetTicks() << " ticks took longer than "
+        << m_deltaTime << " s, the longest " 
+        << m_tickCounters->GetMaxComputeTime() << " s." << std::endl;
+  }
+  m_tickCounters->Reset();
+}
+
+/**
+ * Interpolates the voltage of an IR sensor at a distance from the 
+ * calibration points, which are sorted by distance.
+ */
+float Differential::ConvertDistanceToVoltage(double a_distance) const
+{
+  uint32_t i = 1;
+  while (i + 1 < m_irCalibration.size() 
+      && a_distance > m_irCalibration[i].first) {
+    i++;
   }
+  std::pair<double, float> const &a = m_irCalibration[i - 1];
+  std::pair<double, float> const &b = m_irCalibration[i];
+  double const width = b.first - a.first;
+  double const t = (width > 0.0) 
+      ? std::min(std::max((a_distance - a.first) / width, 0.0), 1.0) : 0.0;
+  return a.second + static_cast<float>(t) * (b.second - a.second);
 }
 
-void Differential::SetMotorControl(uint16_t a_pin, bool a_state)
+void Differential::SetMotorControl(uint32_t a_robot, uint16_t a_pin, 
+    bool a_state)
 {
+  MotorCommand &command = m_commands[a_robot];
   switch (a_pin) {
     case 30:
       {
-        m_gpioInB = a_state;
+        command.gpioInB = a_state;
         break;
       }
     case 31:
       {
-        m_gpioInA = a_state;
+        command.gpioInA = a_state;
         break;
       }
     case 60:
       {
-        m_gpioInC = a_state;
+        command.gpioInC = a_state;
         break;
       }
     case 51:
       {
-        m_gpioInD = a_state;
+        command.gpioInD = a_state;
         break;
       }
     default:
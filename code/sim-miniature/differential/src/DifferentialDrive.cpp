@@ -0,0 +1,88 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <string>
+
+#include "DifferentialDrive.h"
+#include "Fleet.h"
+
+namespace opendlv {
+namespace sim {
+namespace miniature {
+
+DifferentialDrive::DifferentialDrive(double const a_wheelRadius, 
+    double const a_trackWidth, Integrator const a_integrator, 
+    double const a_substepTime)
+    : m_fleet(new Fleet(1, a_wheelRadius, a_trackWidth, a_integrator, 
+          a_substepTime))
+{
+}
+
+DifferentialDrive::~DifferentialDrive()
+{
+}
+
+/**
+ * Parses "euler", "midpoint" or "rk4".
+ */
+bool DifferentialDrive::ParseIntegrator(std::string const &a_name, 
+    Integrator &a_integrator)
+{
+  if (a_name == "euler") {
+    a_integrator = EULER;
+  } else if (a_name == "midpoint") {
+    a_integrator = MIDPOINT;
+  } else if (a_name == "rk4") {
+    a_integrator = RK4;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void DifferentialDrive::SetWheelAngularVelocities(double const a_left, 
+    double const a_right)
+{
+  m_fleet->SetWheelAngularVelocities(0, a_left, a_right);
+}
+
+double DifferentialDrive::GetLinearVelocity() const
+{
+  return m_fleet->GetLinearVelocity(0);
+}
+
+double DifferentialDrive::GetYawRate() const
+{
+  return m_fleet->GetYawRate(0);
+}
+
+/**
+ * Advances the pose by the time step, and returns the number of substeps.
+ */
+uint32_t DifferentialDrive::Step(DifferentialPose &a_pose, 
+    double const a_deltaTime)
+{
+  m_fleet->SetPose(0, a_pose);
+  uint32_t const substeps = m_fleet->Step(a_deltaTime);
+  a_pose = m_fleet->GetPose(0);
+  return substeps;
+}
+
+}
+}
+}
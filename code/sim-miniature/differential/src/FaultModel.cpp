@@ -0,0 +1,126 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "FaultModel.h"
+
+namespace opendlv {
+namespace sim {
+namespace miniature {
+
+/**
+ * Takes the standard deviations of the position (m) and yaw (rad) noise,
+ * the share of messages dropped, the latency and its jitter (s), the 
+ * chance per reading that a sensor gets stuck, and for how long (s).
+ */
+FaultModel::FaultModel(double const a_positionNoise, double const a_yawNoise,
+    double const a_dropout, double const a_latency, 
+    double const a_latencyJitter, double const a_stuckProbability, 
+    double const a_stuckDuration)
+    : m_positionNoise(a_positionNoise)
+    , m_yawNoise(a_yawNoise)
+    , m_dropout(a_dropout)
+    , m_latency(a_latency)
+    , m_latencyJitter(a_latencyJitter)
+    , m_stuckProbability(a_stuckProbability)
+    , m_stuckDuration(a_stuckDuration)
+    , m_stuckUntil()
+    , m_stuckFound()
+    , m_stuckDistance()
+{
+}
+
+FaultModel::~FaultModel()
+{
+}
+
+void FaultModel::AddPoseNoise(DifferentialPose &a_pose, 
+    std::mt19937 &a_random) const
+{
+  if (m_positionNoise > 0.0) {
+    std::normal_distribution<double> noise(0.0, m_positionNoise);
+    a_pose.x += noise(a_random);
+    a_pose.y += noise(a_random);
+  }
+  if (m_yawNoise > 0.0) {
+    std::normal_distribution<double> noise(0.0, m_yawNoise);
+    double const yaw = a_pose.yaw + noise(a_random);
+    a_pose.yaw = std::atan2(std::sin(yaw), std::cos(yaw));
+  }
+}
+
+bool FaultModel::IsDropped(std::mt19937 &a_random) const
+{
+  if (!(m_dropout > 0.0)) {
+    return false;
+  }
+  std::bernoulli_distribution dropped(m_dropout);
+  return dropped(a_random);
+}
+
+/**
+ * Returns how long a message is held back before it is sent.
+ */
+double FaultModel::GetDelay(std::mt19937 &a_random) const
+{
+  double delay = m_latency;
+  if (m_latencyJitter > 0.0) {
+    std::uniform_real_distribution<double> jitter(0.0, m_latencyJitter);
+    delay += jitter(a_random);
+  }
+  return delay;
+}
+
+/**
+ * Replaces a reading of a sensor by the one it is stuck at, or lets the 
+ * sensor get stuck at this reading.
+ */
+void FaultModel::ApplyStuck(uint32_t const a_sensor, double const a_time, 
+    bool &a_found, double &a_distance, std::mt19937 &a_random)
+{
+  if (a_sensor >= m_stuckUntil.size()) {
+    m_stuckUntil.resize(a_sensor + 1, -1.0);
+    m_stuckFound.resize(a_sensor + 1, false);
+    m_stuckDistance.resize(a_sensor + 1, 0.0);
+  }
+  if (IsStuck(a_sensor, a_time)) {
+    a_found = m_stuckFound[a_sensor];
+    a_distance = m_stuckDistance[a_sensor];
+    return;
+  }
+  if (m_stuckProbability > 0.0) {
+    std::bernoulli_distribution stuck(m_stuckProbability);
+    if (stuck(a_random)) {
+      m_stuckUntil[a_sensor] = a_time + m_stuckDuration;
+      m_stuckFound[a_sensor] = a_found;
+      m_stuckDistance[a_sensor] = a_distance;
+    }
+  }
+}
+
+bool FaultModel::IsStuck(uint32_t const a_sensor, double const a_time) const
+{
+  return (a_sensor < m_stuckUntil.size() && a_time < m_stuckUntil[a_sensor]);
+}
+
+}
+}
+}
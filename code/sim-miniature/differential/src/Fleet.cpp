@@ -0,0 +1,274 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <cmath>
+#include <vector>
+
+#include "Fleet.h"
+
+namespace opendlv {
+namespace sim {
+namespace miniature {
+
+Fleet::Fleet(uint32_t const a_size, double const a_wheelRadius, 
+    double const a_trackWidth, DifferentialDrive::Integrator const a_integrator,
+    double const a_substepTime)
+    : m_size(a_size)
+    , m_wheelRadius(a_wheelRadius)
+    , m_trackWidth(a_trackWidth)
+    , m_integrator(a_integrator)
+    , m_substepTime(a_substepTime)
+    , m_timeConstant(0.0)
+    , m_x(a_size, 0.0)
+    , m_y(a_size, 0.0)
+    , m_yaw(a_size, 0.0)
+    , m_linearVelocity(a_size, 0.0)
+    , m_yawRate(a_size, 0.0)
+    , m_leftWheel(a_size, 0.0)
+    , m_rightWheel(a_size, 0.0)
+    , m_leftTarget(a_size, 0.0)
+    , m_rightTarget(a_size, 0.0)
+    , m_prevX(a_size, 0.0)
+    , m_prevY(a_size, 0.0)
+    , m_stageX(a_size, 0.0)
+    , m_stageY(a_size, 0.0)
+    , m_sumX(a_size, 0.0)
+    , m_sumY(a_size, 0.0)
+    , m_collisionModel(nullptr)
+{
+}
+
+Fleet::~Fleet()
+{
+}
+
+uint32_t Fleet::GetSize() const
+{
+  return m_size;
+}
+
+void Fleet::SetPose(uint32_t const a_index, DifferentialPose const &a_pose)
+{
+  m_x[a_index] = a_pose.x;
+  m_y[a_index] = a_pose.y;
+  m_yaw[a_index] = a_pose.yaw;
+}
+
+DifferentialPose Fleet::GetPose(uint32_t const a_index) const
+{
+  DifferentialPose pose = {m_x[a_index], m_y[a_index], m_yaw[a_index]};
+  return pose;
+}
+
+/**
+ * Sets the wheel angular velocities of a robot at once.
+ */
+void Fleet::SetWheelAngularVelocities(uint32_t const a_index, 
+    double const a_left, double const a_right)
+{
+  m_leftWheel[a_index] = a_left;
+  m_rightWheel[a_index] = a_right;
+  m_leftTarget[a_index] = a_left;
+  m_rightTarget[a_index] = a_right;
+  m_linearVelocity[a_index] = m_wheelRadius * (a_left + a_right) / 2.0;
+  m_yawRate[a_index] = m_wheelRadius * (a_right - a_left) / m_trackWidth;
+}
+
+/**
+ * Sets the wheel angular velocities a robot approaches with the time 
+ * constant.
+ */
+void Fleet::SetWheelTargets(uint32_t const a_index, double const a_left, 
+    double const a_right)
+{
+  m_leftTarget[a_index] = a_left;
+  m_rightTarget[a_index] = a_right;
+}
+
+void Fleet::GetWheelAngularVelocities(uint32_t const a_index, double &a_left,
+    double &a_right) const
+{
+  a_left = m_leftWheel[a_index];
+  a_right = m_rightWheel[a_index];
+}
+
+void Fleet::GetWheelTargets(uint32_t const a_index, double &a_left,
+    double &a_right) const
+{
+  a_left = m_leftTarget[a_index];
+  a_right = m_rightTarget[a_index];
+}
+
+/**
+ * Sets the time constant of the wheel velocities, zero follows the targets
+ * at once.
+ */
+void Fleet::SetTimeConstant(double const a_timeConstant)
+{
+  m_timeConstant = a_timeConstant;
+}
+
+double Fleet::GetLinearVelocity(uint32_t const a_index) const
+{
+  return m_linearVelocity[a_index];
+}
+
+double Fleet::GetYawRate(uint32_t const a_index) const
+{
+  return m_yawRate[a_index];
+}
+
+/**
+ * Sets the collision model to apply at each substep, which is not owned.
+ */
+void Fleet::SetCollisionModel(CollisionModel *a_collisionModel)
+{
+  m_collisionModel = a_collisionModel;
+}
+
+/**
+ * Advances all robots by the time step, and returns the number of 
+ * substeps.
+ */
+uint32_t Fleet::Step(double const a_deltaTime)
+{
+  if (!(a_deltaTime > 0.0)) {
+    return 0;
+  }
+  uint32_t substeps = 1;
+  if (m_substepTime > 0.0) {
+    substeps = static_cast<uint32_t>(std::ceil(a_deltaTime / m_substepTime 
+          - 1e-9));
+    if (substeps == 0) {
+      substeps = 1;
+    }
+  }
+  double const h = a_deltaTime / substeps;
+  for (uint32_t i = 0; i < substeps; i++) {
+    Substep(h);
+  }
+  return substeps;
+}
+
+/**
+ * Moves the wheel velocities toward their targets over a substep, exactly
+ * for a first order lag with the targets held.
+ */
+void Fleet::UpdateWheels(double const a_h)
+{
+  double const share = (m_timeConstant > 0.0) 
+      ? 1.0 - std::exp(-a_h / m_timeConstant) : 1.0;
+  for (uint32_t i = 0; i < m_size; i++) {
+    m_leftWheel[i] += share * (m_leftTarget[i] - m_leftWheel[i]);
+    m_rightWheel[i] += share * (m_rightTarget[i] - m_rightWheel[i]);
+    m_linearVelocity[i] = m_wheelRadius * (m_leftWheel[i] + m_rightWheel[i])
+        / 2.0;
+    m_yawRate[i] = m_wheelRadius * (m_rightWheel[i] - m_leftWheel[i]) 
+        / m_trackWidth;
+  }
+}
+
+/**
+ * Evaluates the velocity of every robot at an integration stage, the given
+ * time into the substep. As the velocity only depends on the heading, and 
+ * the yaw rate is held, the stage only needs the heading reached by then.
+ */
+void Fleet::EvaluateStage(double const a_time)
+{
+  for (uint32_t i = 0; i < m_size; i++) {
+    double const yaw = m_yaw[i] + a_time * m_yawRate[i];
+    m_stageX[i] = m_linearVelocity[i] * std::cos(yaw);
+    m_stageY[i] = m_linearVelocity[i] * std::sin(yaw);
+  }
+}
+
+/**
+ * Integrates all robots over one substep. The two middle stages of RK4 
+ * reach the same heading and give the same velocity, but all four are 
+ * evaluated as written.
+ */
+void Fleet::Substep(double const a_h)
+{
+  UpdateWheels(a_h);
+
+  if (m_collisionModel != nullptr) {
+    m_prevX = m_x;
+    m_prevY = m_y;
+  }
+
+  switch (m_integrator) {
+    case DifferentialDrive::EULER:
+      {
+        EvaluateStage(0.0);
+        for (uint32_t i = 0; i < m_size; i++) {
+          m_x[i] += a_h * m_stageX[i];
+          m_y[i] += a_h * m_stageY[i];
+          m_yaw[i] += a_h * m_yawRate[i];
+        }
+        break;
+      }
+    case DifferentialDrive::MIDPOINT:
+      {
+        EvaluateStage(a_h / 2.0);
+        for (uint32_t i = 0; i < m_size; i++) {
+          m_x[i] += a_h * m_stageX[i];
+          m_y[i] += a_h * m_stageY[i];
+          m_yaw[i] += a_h * m_yawRate[i];
+        }
+        break;
+      }
+    case DifferentialDrive::RK4:
+      {
+        EvaluateStage(0.0);
+        for (uint32_t i = 0; i < m_size; i++) {
+          m_sumX[i] = m_stageX[i];
+          m_sumY[i] = m_stageY[i];
+        }
+        EvaluateStage(a_h / 2.0);
+        for (uint32_t i = 0; i < m_size; i++) {
+          m_sumX[i] += 2.0 * m_stageX[i];
+          m_sumY[i] += 2.0 * m_stageY[i];
+        }
+        EvaluateStage(a_h / 2.0);
+        for (uint32_t i = 0; i < m_size; i++) {
+          m_sumX[i] += 2.0 * m_stageX[i];
+          m_sumY[i] += 2.0 * m_stageY[i];
+        }
+        EvaluateStage(a_h);
+        for (uint32_t i = 0; i < m_size; i++) {
+          m_x[i] += a_h / 6.0 * (m_sumX[i] + m_stageX[i]);
+          m_y[i] += a_h / 6.0 * (m_sumY[i] + m_stageY[i]);
+          m_yaw[i] += a_h * m_yawRate[i];
+        }
+        break;
+      }
+  }
+
+  // The yaw is kept within [-pi, pi].
+  for (uint32_t i = 0; i < m_size; i++) {
+    m_yaw[i] = std::atan2(std::sin(m_yaw[i]), std::cos(m_yaw[i]));
+  }
+
+  if (m_collisionModel != nullptr) {
+    m_collisionModel->Resolve(m_prevX, m_prevY, m_x, m_y);
+  }
+}
+
+}
+}
+}
@@ -0,0 +1,89 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "MotorModel.h"
+
+namespace opendlv {
+namespace sim {
+namespace miniature {
+
+MotorModel::MotorModel(uint32_t const a_minPulseNs, 
+    uint32_t const a_neutralPulseNs, uint32_t const a_maxPulseNs, 
+    double const a_deadband, double const a_exponent, 
+    double const a_maxAngularVelocity, double const a_timeConstant)
+    : m_minPulseNs(a_minPulseNs)
+    , m_neutralPulseNs(std::min(std::max(a_neutralPulseNs, a_minPulseNs), 
+          a_maxPulseNs))
+    , m_maxPulseNs(a_maxPulseNs)
+    , m_deadband(std::min(std::max(a_deadband, 0.0), 0.99))
+    , m_exponent(a_exponent > 0.0 ? a_exponent : 1.0)
+    , m_maxAngularVelocity(a_maxAngularVelocity)
+    , m_timeConstant(std::max(a_timeConstant, 0.0))
+{
+}
+
+MotorModel::~MotorModel()
+{
+}
+
+/**
+ * Returns the command of a pulse width, saturated to the pulse range. No
+ * pulse at all gives no command.
+ */
+double MotorModel::GetCommand(uint32_t const a_pulseNs) const
+{
+  if (a_pulseNs == 0) {
+    return 0.0;
+  }
+  double const pulseNs = static_cast<double>(a_pulseNs);
+  double const neutralNs = static_cast<double>(m_neutralPulseNs);
+  double command = 0.0;
+  if (pulseNs > neutralNs && m_maxPulseNs > m_neutralPulseNs) {
+    command = (pulseNs - neutralNs) / (m_maxPulseNs - neutralNs);
+  } else if (pulseNs < neutralNs && m_neutralPulseNs > m_minPulseNs) {
+    command = (pulseNs - neutralNs) / (neutralNs - m_minPulseNs);
+  }
+  return std::min(std::max(command, -1.0), 1.0);
+}
+
+/**
+ * Returns the angular velocity the wheel settles at for a command.
+ */
+double MotorModel::GetAngularVelocity(double const a_command) const
+{
+  double const magnitude = std::min(std::abs(a_command), 1.0);
+  if (!(magnitude > m_deadband)) {
+    return 0.0;
+  }
+  double const share = std::pow((magnitude - m_deadband) 
+      / (1.0 - m_deadband), m_exponent);
+  double const angularVelocity = m_maxAngularVelocity * share;
+  return (a_command < 0.0) ? -angularVelocity : angularVelocity;
+}
+
+double MotorModel::GetTimeConstant() const
+{
+  return m_timeConstant;
+}
+
+}
+}
+}
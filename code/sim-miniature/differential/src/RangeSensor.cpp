@@ -0,0 +1,100 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "RangeSensor.h"
+
+namespace opendlv {
+namespace sim {
+namespace miniature {
+
+/**
+ * Angles are in radians, counter clockwise from the robot heading, and 
+ * the noise is the standard deviation of a measurement.
+ */
+RangeSensor::RangeSensor(uint32_t const a_id, double const a_x, 
+    double const a_y, double const a_angle, double const a_fieldOfView, 
+    double const a_range, uint32_t const a_rays, double const a_noise)
+    : m_id(a_id)
+    , m_x(a_x)
+    , m_y(a_y)
+    , m_angle(a_angle)
+    , m_fieldOfView(a_fieldOfView)
+    , m_range(a_range)
+    , m_rays(std::max(a_rays, 1u))
+    , m_noise(a_noise)
+{
+}
+
+RangeSensor::~RangeSensor()
+{
+}
+
+uint32_t RangeSensor::GetId() const
+{
+  return m_id;
+}
+
+double RangeSensor::GetRange() const
+{
+  return m_range;
+}
+
+/**
+ * Measures the distance from the sensor to the nearest wall within range,
+ * returns false if there is none.
+ */
+bool RangeSensor::Measure(WallGrid const &a_walls, 
+    DifferentialPose const &a_pose, std::mt19937 &a_random, 
+    double &a_distance) const
+{
+  double const cosYaw = std::cos(a_pose.yaw);
+  double const sinYaw = std::sin(a_pose.yaw);
+  double const x = a_pose.x + cosYaw * m_x - sinYaw * m_y;
+  double const y = a_pose.y + sinYaw * m_x + cosYaw * m_y;
+  double const heading = a_pose.yaw + m_angle;
+
+  bool found = false;
+  double nearest = m_range;
+  for (uint32_t i = 0; i < m_rays; i++) {
+    double const offset = (m_rays == 1) ? 0.0 
+        : m_fieldOfView * (static_cast<double>(i) / (m_rays - 1) - 0.5);
+    double distance;
+    if (a_walls.CastRay(x, y, heading + offset, nearest, distance)) {
+      nearest = distance;
+      found = true;
+    }
+  }
+  if (!found) {
+    return false;
+  }
+
+  if (m_noise > 0.0) {
+    std::normal_distribution<double> noise(0.0, m_noise);
+    nearest += noise(a_random);
+  }
+  a_distance = std::min(std::max(nearest, 0.0), m_range);
+  return true;
+}
+
+}
+}
+}
@@ -0,0 +1,324 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "WallGrid.h"
+
+namespace opendlv {
+namespace sim {
+namespace miniature {
+
+uint32_t const WallGrid::MAX_CELLS;
+
+WallGrid::WallGrid()
+    : m_segments()
+    , m_minX(0.0)
+    , m_minY(0.0)
+    , m_cellSize(1.0)
+    , m_columns(0)
+    , m_rows(0)
+    , m_cellStart()
+    , m_cellSegments()
+{
+}
+
+WallGrid::~WallGrid()
+{
+}
+
+void WallGrid::AddSegment(WallSegment const &a_segment)
+{
+  m_segments.push_back(a_segment);
+}
+
+/**
+ * Adds the edges of a closed polygon given as vertex coordinates.
+ */
+void WallGrid::AddPolygon(std::vector<double> const &a_x, 
+    std::vector<double> const &a_y)
+{
+  uint32_t const size = static_cast<uint32_t>(std::min(a_x.size(), 
+        a_y.size()));
+  if (size < 2) {
+    return;
+  }
+  for (uint32_t i = 0; i < size; i++) {
+    uint32_t const j = (i + 1) % size;
+    if (size == 2 && j == 0) {
+      break;
+    }
+    WallSegment const segment = {a_x[i], a_y[i], a_x[j], a_y[j]};
+    AddSegment(segment);
+  }
+}
+
+/**
+ * Sorts the segments into cells of the given size. The cells are made 
+ * larger if the walls would need more than MAX_CELLS of them.
+ */
+void WallGrid::Build(double const a_cellSize)
+{
+  m_cellStart.clear();
+  m_cellSegments.clear();
+  m_columns = 0;
+  m_rows = 0;
+  if (m_segments.empty() || !(a_cellSize > 0.0)) {
+    return;
+  }
+
+  double minX = std::numeric_limits<double>::max();
+  double minY = std::numeric_limits<double>::max();
+  double maxX = -std::numeric_limits<double>::max();
+  double maxY = -std::numeric_limits<double>::max();
+  for (WallSegment const &segment : m_segments) {
+    minX = std::min(minX, std::min(segment.x1, segment.x2));
+    minY = std::min(minY, std::min(segment.y1, segment.y2));
+    maxX = std::max(maxX, std::max(segment.x1, segment.x2));
+    maxY = std::max(maxY, std::max(segment.y1, segment.y2));
+  }
+
+  m_cellSize = a_cellSize;
+  double const width = maxX - minX;
+  double const height = maxY - minY;
+  while ((width / m_cellSize + 1.0) * (height / m_cellSize + 1.0) 
+      > MAX_CELLS) {
+    m_cellSize *= 2.0;
+  }
+  m_minX = minX;
+  m_minY = minY;
+  m_columns = static_cast<int32_t>(width / m_cellSize) + 1;
+  m_rows = static_cast<int32_t>(height / m_cellSize) + 1;
+
+  // Each segment goes into the cells covered by its bounding box, counted
+  // first so that all cells share one index array.
+  uint32_t const cellCount = static_cast<uint32_t>(m_columns * m_rows);
+  m_cellStart.assign(cellCount + 1, 0);
+  for (uint32_t pass = 0; pass < 2; pass++) {
+    std::vector<uint32_t> fill;
+    if (pass == 1) {
+      for (uint32_t c = 0; c < cellCount; c++) {
+        m_cellStart[c + 1] += m_cellStart[c];
+      }
+      m_cellSegments.assign(m_cellStart[cellCount], 0);
+      fill.assign(m_cellStart.begin(), m_cellStart.end() - 1);
+    }
+    for (uint32_t s = 0; s < m_segments.size(); s++) {
+      WallSegment const &segment = m_segments[s];
+      int32_t const column0 = static_cast<int32_t>(
+          (std::min(segment.x1, segment.x2) - m_minX) / m_cellSize);
+      int32_t const column1 = static_cast<int32_t>(
+          (std::max(segment.x1, segment.x2) - m_minX) / m_cellSize);
+      int32_t const row0 = static_cast<int32_t>(
+          (std::min(segment.y1, segment.y2) - m_minY) / m_cellSize);
+      int32_t const row1 = static_cast<int32_t>(
+          (std::max(segment.y1, segment.y2) - m_minY) / m_cellSize);
+      for (int32_t row = row0; row <= row1; row++) {
+        for (int32_t column = column0; column <= column1; column++) {
+          uint32_t const c = static_cast<uint32_t>(row * m_columns + column);
+          if (pass == 0) {
+            m_cellStart[c + 1]++;
+          } else {
+            m_cellSegments[fill[c]++] = s;
+          }
+        }
+      }
+    }
+  }
+}
+
+uint32_t WallGrid::GetSegmentCount() const
+{
+  return static_cast<uint32_t>(m_segments.size());
+}
+
+WallSegment const &WallGrid::GetSegment(uint32_t const a_index) const
+{
+  return m_segments[a_index];
+}
+
+/**
+ * Collects the indices of the segments in the cells overlapping a box, 
+ * each once. Segments near the box, but outside it, may be included.
+ */
+void WallGrid::FindSegments(double const a_minX, double const a_minY, 
+    double const a_maxX, double const a_maxY, 
+    std::vector<uint32_t> &a_segments) const
+{
+  a_segments.clear();
+  if (m_columns == 0) {
+    return;
+  }
+  int32_t const column0 = std::max(static_cast<int32_t>(
+        std::floor((a_minX - m_minX) / m_cellSize)), 0);
+  int32_t const column1 = std::min(static_cast<int32_t>(
+        std::floor((a_maxX - m_minX) / m_cellSize)), m_columns - 1);
+  int32_t const row0 = std::max(static_cast<int32_t>(
+        std::floor((a_minY - m_minY) / m_cellSize)), 0);
+  int32_t const row1 = std::min(static_cast<int32_t>(
+        std::floor((a_maxY - m_minY) / m_cellSize)), m_rows - 1);
+  for (int32_t row = row0; row <= row1; row++) {
+    for (int32_t column = column0; column <= column1; column++) {
+      uint32_t const c = static_cast<uint32_t>(row * m_columns + column);
+      a_segments.insert(a_segments.end(), 
+          m_cellSegments.begin() + m_cellStart[c], 
+          m_cellSegments.begin() + m_cellStart[c + 1]);
+    }
+  }
+  if (row1 > row0 || column1 > column0) {
+    std::sort(a_segments.begin(), a_segments.end());
+    a_segments.erase(std::unique(a_segments.begin(), a_segments.end()), 
+        a_segments.end());
+  }
+}
+
+/**
+ * Finds the nearest wall along a ray from a point in a direction, within
+ * a range. The cells are walked in the order the ray passes them, and the
+ * walk stops at the first cell that holds a hit.
+ */
+bool WallGrid::CastRay(double const a_x, double const a_y, 
+    double const a_angle, double const a_range, double &a_distance) const
+{
+  if (m_columns == 0) {
+    return false;
+  }
+
+  double const dx = std::cos(a_angle);
+  double const dy = std::sin(a_angle);
+
+  // Clip the ray to the grid bounds.
+  double const maxX = m_minX + m_columns * m_cellSize;
+  double const maxY = m_minY + m_rows * m_cellSize;
+  double enter = 0.0;
+  double exit = a_range;
+  double const origins[2] = {a_x, a_y};
+  double const directions[2] = {dx, dy};
+  double const mins[2] = {m_minX, m_minY};
+  double const maxs[2] = {maxX, maxY};
+  for (uint32_t axis = 0; axis < 2; axis++) {
+    if (std::abs(directions[axis]) < 1e-12) {
+      if (origins[axis] < mins[axis] || origins[axis] > maxs[axis]) {
+        return false;
+      }
+    } else {
+      double t0 = (mins[axis] - origins[axis]) / directions[axis];
+      double t1 = (maxs[axis] - origins[axis]) / directions[axis];
+      if (t0 > t1) {
+        std::swap(t0, t1);
+      }
+      enter = std::max(enter, t0);
+      exit = std::min(exit, t1);
+    }
+  }
+  if (enter > exit) {
+    return false;
+  }
+
+  double const startX = a_x + enter * dx;
+  double const startY = a_y + enter * dy;
+  int32_t column = std::min(std::max(static_cast<int32_t>(
+          std::floor((startX - m_minX) / m_cellSize)), 0), m_columns - 1);
+  int32_t row = std::min(std::max(static_cast<int32_t>(
+          std::floor((startY - m_minY) / m_cellSize)), 0), m_rows - 1);
+
+  double const infinity = std::numeric_limits<double>::infinity();
+  int32_t const stepColumn = (dx > 0.0) ? 1 : -1;
+  int32_t const stepRow = (dy > 0.0) ? 1 : -1;
+  double const deltaX = (std::abs(dx) < 1e-12) ? infinity 
+      : m_cellSize / std::abs(dx);
+  double const deltaY = (std::abs(dy) < 1e-12) ? infinity 
+      : m_cellSize / std::abs(dy);
+  double nextX = infinity;
+  if (std::abs(dx) >= 1e-12) {
+    double const edge = m_minX + (column + (dx > 0.0 ? 1 : 0)) * m_cellSize;
+    nextX = (edge - a_x) / dx;
+  }
+  double nextY = infinity;
+  if (std::abs(dy) >= 1e-12) {
+    double const edge = m_minY + (row + (dy > 0.0 ? 1 : 0)) * m_cellSize;
+    nextY = (edge - a_y) / dy;
+  }
+
+  double nearest = infinity;
+  while (true) {
+    uint32_t const c = static_cast<uint32_t>(row * m_columns + column);
+    double hit;
+    if (IntersectCell(c, a_x, a_y, dx, dy, hit) && hit <= a_range) {
+      nearest = std::min(nearest, hit);
+    }
+
+    // A hit in this cell can not be beaten by a later cell once the ray 
+    // has reached it.
+    double const cellExit = std::min(nextX, nextY);
+    if (nearest <= cellExit || cellExit > exit) {
+      break;
+    }
+    if (nextX < nextY) {
+      column += stepColumn;
+      nextX += deltaX;
+    } else {
+      row += stepRow;
+      nextY += deltaY;
+    }
+    if (column < 0 || column >= m_columns || row < 0 || row >= m_rows) {
+      break;
+    }
+  }
+
+  if (nearest <= a_range) {
+    a_distance = nearest;
+    return true;
+  }
+  return false;
+}
+
+/**
+ * Finds the nearest hit of a ray among the segments of a cell.
+ */
+bool WallGrid::IntersectCell(uint32_t const a_cell, double const a_x, 
+    double const a_y, double const a_dx, double const a_dy, double &a_hit) 
+    const
+{
+  bool found = false;
+  for (uint32_t i = m_cellStart[a_cell]; i < m_cellStart[a_cell + 1]; i++) {
+    WallSegment const &segment = m_segments[m_cellSegments[i]];
+    double const ex = segment.x2 - segment.x1;
+    double const ey = segment.y2 - segment.y1;
+    double const denominator = a_dx * ey - a_dy * ex;
+    if (std::abs(denominator) < 1e-12) {
+      continue;
+    }
+    double const wx = segment.x1 - a_x;
+    double const wy = segment.y1 - a_y;
+    double const t = (wx * ey - wy * ex) / denominator;
+    double const u = (wx * a_dy - wy * a_dx) / denominator;
+    if (t >= 0.0 && u >= 0.0 && u <= 1.0 && (!found || t < a_hit)) {
+      a_hit = t;
+      found = true;
+    }
+  }
+  return found;
+}
+
+}
+}
+}
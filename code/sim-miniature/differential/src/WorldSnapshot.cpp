@@ -0,0 +1,188 @@
+/**
+ * Copyright (C) 2017 Chalmers Revere
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "WorldSnapshot.h"
+
+namespace opendlv {
+namespace sim {
+namespace miniature {
+
+uint32_t const WorldSnapshot::MAGIC;
+uint32_t const WorldSnapshot::VERSION;
+uint32_t const WorldSnapshot::RANDOM_WORDS;
+
+WorldSnapshot::WorldSnapshot()
+    : simulationTime(0.0)
+    , randomWords(RANDOM_WORDS, 0)
+    , randomIndex(RANDOM_WORDS)
+    , robots()
+{
+}
+
+WorldSnapshot::~WorldSnapshot()
+{
+}
+
+template<typename T>
+void WorldSnapshot::WriteValue(std::ostream &a_out, T const &a_value)
+{
+  a_out.write(reinterpret_cast<char const *>(&a_value), sizeof(T));
+}
+
+template<typename T>
+bool WorldSnapshot::ReadValue(std::istream &a_in, T &a_value)
+{
+  a_in.read(reinterpret_cast<char *>(&a_value), sizeof(T));
+  return !a_in.fail();
+}
+
+bool WorldSnapshot::Write(std::ostream &a_out) const
+{
+  WriteValue(a_out, MAGIC);
+  WriteValue(a_out, VERSION);
+  WriteValue(a_out, simulationTime);
+  for (uint32_t i = 0; i < RANDOM_WORDS; i++) {
+    WriteValue(a_out, i < randomWords.size() ? randomWords[i] : 0u);
+  }
+  WriteValue(a_out, randomIndex);
+  WriteValue(a_out, static_cast<uint32_t>(robots.size()));
+  for (RobotSnapshot const &robot : robots) {
+    WriteValue(a_out, robot.x);
+    WriteValue(a_out, robot.y);
+    WriteValue(a_out, robot.yaw);
+    WriteValue(a_out, robot.leftWheel);
+    WriteValue(a_out, robot.rightWheel);
+    WriteValue(a_out, robot.leftTarget);
+    WriteValue(a_out, robot.rightTarget);
+    WriteValue(a_out, robot.leftDutyCycleNs);
+    WriteValue(a_out, robot.rightDutyCycleNs);
+    WriteValue(a_out, robot.gpio);
+  }
+  return a_out.good();
+}
+
+/**
+ * Reads a snapshot, and returns false if it is not one of this version or
+ * is cut short. The snapshot is only changed when the whole of it is read.
+ */
+bool WorldSnapshot::Read(std::istream &a_in)
+{
+  uint32_t magic = 0;
+  uint32_t version = 0;
+  if (!ReadValue(a_in, magic) || magic != MAGIC 
+      || !ReadValue(a_in, version) || version != VERSION) {
+    return false;
+  }
+  double time = 0.0;
+  if (!ReadValue(a_in, time)) {
+    return false;
+  }
+  std::vector<uint32_t> words(RANDOM_WORDS, 0);
+  for (uint32_t i = 0; i < RANDOM_WORDS; i++) {
+    if (!ReadValue(a_in, words[i])) {
+      return false;
+    }
+  }
+  uint32_t index = 0;
+  uint32_t robotCount = 0;
+  if (!ReadValue(a_in, index) || index > RANDOM_WORDS 
+      || !ReadValue(a_in, robotCount)) {
+    return false;
+  }
+  std::vector<RobotSnapshot> robotsRead;
+  for (uint32_t i = 0; i < robotCount; i++) {
+    RobotSnapshot robot;
+    if (!ReadValue(a_in, robot.x) || !ReadValue(a_in, robot.y) 
+        || !ReadValue(a_in, robot.yaw) || !ReadValue(a_in, robot.leftWheel) 
+        || !ReadValue(a_in, robot.rightWheel) 
+        || !ReadValue(a_in, robot.leftTarget) 
+        || !ReadValue(a_in, robot.rightTarget) 
+        || !ReadValue(a_in, robot.leftDutyCycleNs) 
+        || !ReadValue(a_in, robot.rightDutyCycleNs) 
+        || !ReadValue(a_in, robot.gpio)) {
+      return false;
+    }
+    robotsRead.push_back(robot);
+  }
+
+  simulationTime = time;
+  randomWords.swap(words);
+  randomIndex = index;
+  robots.swap(robotsRead);
+  return true;
+}
+
+bool WorldSnapshot::Save(std::string const &a_filename) const
+{
+  std::ofstream file(a_filename, std::ios::binary | std::ios::trunc);
+  return file.is_open() && Write(file);
+}
+
+bool WorldSnapshot::Load(std::string const &a_filename)
+{
+  std::ifstream file(a_filename, std::ios::binary);
+  return file.is_open() && Read(file);
+}
+
+/**
+ * Keeps the state of a random generator. The generator only shows its 
+ * state as text, the state words followed, by some standard libraries, by
+ * the index of the next word. Without an index the words are the last 
+ * ones drawn, as when the index is past the end.
+ */
+void WorldSnapshot::SetRandom(std::mt19937 const &a_random)
+{
+  std::stringstream text;
+  text << a_random;
+  randomWords.assign(RANDOM_WORDS, 0);
+  for (uint32_t i = 0; i < RANDOM_WORDS; i++) {
+    text >> randomWords[i];
+  }
+  if (!(text >> randomIndex)) {
+    randomIndex = RANDOM_WORDS;
+  }
+}
+
+/**
+ * Sets a random generator to the kept state.
+ */
+bool WorldSnapshot::GetRandom(std::mt19937 &a_random) const
+{
+  if (randomWords.size() != RANDOM_WORDS || randomIndex > RANDOM_WORDS) {
+    return false;
+  }
+  std::stringstream text;
+  for (uint32_t i = 0; i < RANDOM_WORDS; i++) {
+    text << randomWords[i] << ' ';
+  }
+  text << randomIndex;
+  text >> a_random;
+  return !text.fail();
+}
+
+}
+}
+}
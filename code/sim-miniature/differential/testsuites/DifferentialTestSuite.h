@@ -19,10 +19,33 @@
 #ifndef VIRTUAL_MINIATURE_DIFFERENTIAL_TESTSUITE_H
 #define VIRTUAL_MINIATURE_DIFFERENTIAL_TESTSUITE_H
 
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "cxxtest/TestSuite.h"
 
 // Include local header files.
+#include "../include/CollisionModel.h"
+#include "../include/CommandQueue.h"
+#include "../include/DelayLine.h"
 #include "../include/Differential.h"
+#include "../include/DifferentialDrive.h"
+#include "../include/FaultModel.h"
+#include "../include/Fleet.h"
+#include "../include/MotorModel.h"
+#include "../include/RangeSensor.h"
+#include "../../../common-miniature/include/TickCounters.h"
+#include "../include/WallGrid.h"
+#include "../include/WorldSnapshot.h"
+
+using namespace opendlv::sim::miniature;
+using opendlv::common::miniature::TickCounters;
 
 class DifferentialTest : public CxxTest::TestSuite {
    public:
@@ -33,6 +56,621 @@ class DifferentialTest : public CxxTest::TestSuite {
     void testApplication() {
         TS_ASSERT(true);
     }
+
+    void testDriveStraightAndSpin() {
+        DifferentialDrive drive(0.03, 0.12, DifferentialDrive::RK4, 0.001);
+
+        drive.SetWheelAngularVelocities(10.0, 10.0);
+        TS_ASSERT_DELTA(drive.GetLinearVelocity(), 0.3, 1e-12);
+        TS_ASSERT_DELTA(drive.GetYawRate(), 0.0, 1e-12);
+        DifferentialPose pose = {1.0, 2.0, M_PI / 2.0};
+        TS_ASSERT_EQUALS(drive.Step(pose, 0.05), 50u);
+        TS_ASSERT_DELTA(pose.x, 1.0, 1e-9);
+        TS_ASSERT_DELTA(pose.y, 2.015, 1e-9);
+
+        // Opposite wheels turn in place, counter clockwise when the right
+        // wheel goes forward.
+        drive.SetWheelAngularVelocities(-2.0, 2.0);
+        TS_ASSERT_DELTA(drive.GetLinearVelocity(), 0.0, 1e-12);
+        TS_ASSERT_DELTA(drive.GetYawRate(), 1.0, 1e-12);
+        pose = {0.0, 0.0, 0.0};
+        drive.Step(pose, 1.0);
+        TS_ASSERT_DELTA(pose.yaw, 1.0, 1e-9);
+        TS_ASSERT_DELTA(pose.x, 0.0, 1e-12);
+    }
+
+    // Error of a quarter circle of radius 0.5 m, integrated at 20 Hz with
+    // the given substep time.
+    double ArcError(DifferentialDrive::Integrator a_integrator, 
+        double a_substepTime) {
+        DifferentialDrive drive(0.03, 0.12, a_integrator, a_substepTime);
+        // v = 0.25 m/s and yaw rate 0.5 rad/s.
+        double const left = (0.25 - 0.5 * 0.06) / 0.03;
+        double const right = (0.25 + 0.5 * 0.06) / 0.03;
+        drive.SetWheelAngularVelocities(left, right);
+        TS_ASSERT_DELTA(drive.GetYawRate(), 0.5, 1e-12);
+
+        DifferentialPose pose = {0.0, 0.0, 0.0};
+        for (uint32_t i = 0; i < 63; i++) {
+            drive.Step(pose, 0.05);
+        }
+        double const yaw = 0.5 * 63 * 0.05;
+        double const x = 0.5 * std::sin(yaw);
+        double const y = 0.5 * (1.0 - std::cos(yaw));
+        return std::hypot(pose.x - x, pose.y - y);
+    }
+
+    void testIntegratorsConvergeOnArc() {
+        double const euler = ArcError(DifferentialDrive::EULER, 0.0);
+        double const midpoint = ArcError(DifferentialDrive::MIDPOINT, 0.0);
+        double const rk4 = ArcError(DifferentialDrive::RK4, 0.0);
+        TS_ASSERT(euler > 1e-3);
+        TS_ASSERT(midpoint < euler / 10.0);
+        TS_ASSERT(rk4 < midpoint / 100.0);
+
+        // Substepping at 1 kHz makes even Euler accurate.
+        double const eulerSubsteps = ArcError(DifferentialDrive::EULER, 0.001);
+        TS_ASSERT(eulerSubsteps < euler / 10.0);
+        TS_ASSERT(ArcError(DifferentialDrive::RK4, 0.001) < 1e-12);
+
+        DifferentialDrive::Integrator integrator = DifferentialDrive::EULER;
+        TS_ASSERT(DifferentialDrive::ParseIntegrator("midpoint", integrator));
+        TS_ASSERT_EQUALS(integrator, DifferentialDrive::MIDPOINT);
+        TS_ASSERT(!DifferentialDrive::ParseIntegrator("verlet", integrator));
+    }
+
+    void testFleetMatchesSingleDrive() {
+        DifferentialDrive::Integrator const integrators[] = {
+            DifferentialDrive::EULER, DifferentialDrive::MIDPOINT, 
+            DifferentialDrive::RK4};
+        for (DifferentialDrive::Integrator integrator : integrators) {
+            uint32_t const size = 64;
+            Fleet fleet(size, 0.03, 0.12, integrator, 0.001);
+            TS_ASSERT_EQUALS(fleet.GetSize(), size);
+            std::vector<DifferentialPose> poses;
+            for (uint32_t i = 0; i < size; i++) {
+                DifferentialPose pose = {0.1 * i, -0.2 * i, 0.05 * i - 1.0};
+                fleet.SetPose(i, pose);
+                fleet.SetWheelAngularVelocities(i, 0.1 * i, 6.0 - 0.1 * i);
+                poses.push_back(pose);
+            }
+
+            for (uint32_t j = 0; j < 40; j++) {
+                TS_ASSERT_EQUALS(fleet.Step(0.05), 50u);
+            }
+
+            for (uint32_t i = 0; i < size; i++) {
+                DifferentialDrive drive(0.03, 0.12, integrator, 0.001);
+                drive.SetWheelAngularVelocities(0.1 * i, 6.0 - 0.1 * i);
+                TS_ASSERT_DELTA(fleet.GetLinearVelocity(i), 
+                    drive.GetLinearVelocity(), 1e-12);
+                TS_ASSERT_DELTA(fleet.GetYawRate(i), drive.GetYawRate(), 
+                    1e-12);
+                for (uint32_t j = 0; j < 40; j++) {
+                    drive.Step(poses[i], 0.05);
+                }
+                // A robot of the fleet moves exactly as a drive on its own,
+                // a fleet of one, so that the robots do not affect each 
+                // other and the accuracy of the drive is that of the fleet.
+                DifferentialPose const pose = fleet.GetPose(i);
+                TS_ASSERT_EQUALS(pose.x, poses[i].x);
+                TS_ASSERT_EQUALS(pose.y, poses[i].y);
+                TS_ASSERT_EQUALS(pose.yaw, poses[i].yaw);
+            }
+        }
+    }
+
+    void testWallGridMatchesBruteForce() {
+        std::mt19937 random(7);
+        std::uniform_real_distribution<double> position(-5.0, 5.0);
+        std::uniform_real_distribution<double> length(-0.5, 0.5);
+        std::uniform_real_distribution<double> angle(-M_PI, M_PI);
+
+        WallGrid walls;
+        std::vector<WallSegment> segments;
+        for (uint32_t i = 0; i < 400; i++) {
+            double const x = position(random);
+            double const y = position(random);
+            WallSegment const segment = {x, y, x + length(random), 
+                y + length(random)};
+            walls.AddSegment(segment);
+            segments.push_back(segment);
+        }
+        walls.Build(0.3);
+        TS_ASSERT_EQUALS(walls.GetSegmentCount(), 400u);
+
+        uint32_t hits = 0;
+        for (uint32_t i = 0; i < 2000; i++) {
+            // Some rays start outside the walls.
+            double const x = 1.4 * position(random);
+            double const y = 1.4 * position(random);
+            double const a = angle(random);
+            double const range = 3.0;
+
+            double expected = std::numeric_limits<double>::infinity();
+            for (WallSegment const &segment : segments) {
+                double const ex = segment.x2 - segment.x1;
+                double const ey = segment.y2 - segment.y1;
+                double const denominator = std::cos(a) * ey 
+                    - std::sin(a) * ex;
+                if (std::abs(denominator) < 1e-12) {
+                    continue;
+                }
+                double const wx = segment.x1 - x;
+                double const wy = segment.y1 - y;
+                double const t = (wx * ey - wy * ex) / denominator;
+                double const u = (wx * std::sin(a) - wy * std::cos(a)) 
+                    / denominator;
+                if (t >= 0.0 && t <= range && u >= 0.0 && u <= 1.0) {
+                    expected = std::min(expected, t);
+                }
+            }
+
+            double distance = -1.0;
+            bool const found = walls.CastRay(x, y, a, range, distance);
+            TS_ASSERT_EQUALS(found, expected <= range);
+            if (found) {
+                TS_ASSERT_DELTA(distance, expected, 1e-9);
+                hits++;
+            }
+        }
+        TS_ASSERT(hits > 500);
+    }
+
+    void testRangeSensorInBox() {
+        WallGrid walls;
+        std::vector<double> x = {-1.0, 1.0, 1.0, -1.0};
+        std::vector<double> y = {-0.5, -0.5, 0.5, 0.5};
+        walls.AddPolygon(x, y);
+        walls.Build(0.25);
+        TS_ASSERT_EQUALS(walls.GetSegmentCount(), 4u);
+
+        std::mt19937 random(1);
+        DifferentialPose const pose = {0.2, 0.0, M_PI / 2.0};
+
+        // Mounted 0.1 m ahead, looking to the right of the robot.
+        RangeSensor right(3, 0.1, 0.0, -M_PI / 2.0, 0.0, 2.0, 1, 0.0);
+        TS_ASSERT_EQUALS(right.GetId(), 3u);
+        double distance;
+        TS_ASSERT(right.Measure(walls, pose, random, distance));
+        TS_ASSERT_DELTA(distance, 0.8, 1e-9);
+
+        // A wide beam sees the nearest wall in its field of view.
+        RangeSensor wide(0, 0.0, 0.0, -M_PI / 4.0, M_PI / 2.0, 2.0, 11, 0.0);
+        TS_ASSERT(wide.Measure(walls, pose, random, distance));
+        TS_ASSERT_DELTA(distance, 0.5, 1e-9);
+
+        RangeSensor shortRange(0, 0.0, 0.0, 0.0, 0.0, 0.4, 1, 0.0);
+        TS_ASSERT(!shortRange.Measure(walls, pose, random, distance));
+
+        RangeSensor noisy(0, 0.0, 0.0, 0.0, 0.0, 2.0, 1, 0.01);
+        double sum = 0.0;
+        for (uint32_t i = 0; i < 1000; i++) {
+            TS_ASSERT(noisy.Measure(walls, pose, random, distance));
+            sum += distance;
+        }
+        TS_ASSERT_DELTA(sum / 1000, 0.5, 0.002);
+    }
+
+    void testCollisionStopAndSlide() {
+        WallGrid walls;
+        std::vector<double> x = {-1.0, 1.0, 1.0, -1.0};
+        std::vector<double> y = {-1.0, -1.0, 1.0, 1.0};
+        walls.AddPolygon(x, y);
+        walls.Build(0.25);
+
+        // Straight into the wall at x = 1, stopping a radius from it.
+        CollisionModel stop(walls, 0.1, CollisionModel::STOP, true);
+        Fleet fleet(1, 0.03, 0.12, DifferentialDrive::RK4, 0.001);
+        fleet.SetCollisionModel(&stop);
+        fleet.SetWheelAngularVelocities(0, 10.0, 10.0);
+        for (uint32_t i = 0; i < 100; i++) {
+            fleet.Step(0.05);
+        }
+        TS_ASSERT(fleet.GetPose(0).x < 0.9);
+        TS_ASSERT(fleet.GetPose(0).x > 0.899);
+        TS_ASSERT_EQUALS(stop.GetWallCollisions(0), 1u);
+
+        // Turning away is not held back.
+        fleet.SetWheelAngularVelocities(0, -10.0, -10.0);
+        fleet.Step(0.5);
+        TS_ASSERT_DELTA(fleet.GetPose(0).x, 0.9 - 0.15, 1e-3);
+
+        // At 45 degrees into the wall, the robot slides along it.
+        CollisionModel slide(walls, 0.1, CollisionModel::SLIDE, true);
+        Fleet sliding(1, 0.03, 0.12, DifferentialDrive::RK4, 0.001);
+        sliding.SetCollisionModel(&slide);
+        DifferentialPose const start = {0.5, -0.5, M_PI / 4.0};
+        sliding.SetPose(0, start);
+        sliding.SetWheelAngularVelocities(0, 10.0, 10.0);
+        sliding.Step(4.0);
+        DifferentialPose const pose = sliding.GetPose(0);
+        TS_ASSERT(pose.x < 0.9 && pose.x > 0.899);
+        TS_ASSERT_DELTA(pose.y, -0.1 + (1.2 - 0.4 * std::sqrt(2.0)) 
+            / std::sqrt(2.0), 0.01);
+        TS_ASSERT_EQUALS(slide.GetWallCollisions(0), 1u);
+    }
+
+    void testCollisionBetweenRobots() {
+        WallGrid walls;
+        CollisionModel collisions(walls, 0.1, CollisionModel::STOP, true);
+        Fleet fleet(3, 0.03, 0.12, DifferentialDrive::RK4, 0.001);
+        fleet.SetCollisionModel(&collisions);
+
+        // Two robots head on, and a third one far away.
+        DifferentialPose const left = {-0.5, 0.0, 0.0};
+        DifferentialPose const right = {0.5, 0.0, M_PI};
+        DifferentialPose const away = {5.0, 5.0, 0.0};
+        fleet.SetPose(0, left);
+        fleet.SetPose(1, right);
+        fleet.SetPose(2, away);
+        for (uint32_t i = 0; i < 3; i++) {
+            fleet.SetWheelAngularVelocities(i, 10.0, 10.0);
+        }
+        fleet.Step(3.0);
+
+        double const gap = fleet.GetPose(1).x - fleet.GetPose(0).x;
+        TS_ASSERT(gap >= 0.2);
+        TS_ASSERT(gap < 0.201);
+        TS_ASSERT_EQUALS(collisions.GetRobotCollisions(0), 1u);
+        TS_ASSERT_EQUALS(collisions.GetRobotCollisions(1), 1u);
+        TS_ASSERT_EQUALS(collisions.GetRobotCollisions(2), 0u);
+        TS_ASSERT_DELTA(fleet.GetPose(2).x, 5.9, 1e-9);
+    }
+
+    void testCollisionKeepsFleetInArena() {
+        WallGrid walls;
+        std::vector<double> x = {-2.0, 2.0, 2.0, -2.0};
+        std::vector<double> y = {-2.0, -2.0, 2.0, 2.0};
+        walls.AddPolygon(x, y);
+        std::vector<double> innerX = {-0.3, 0.3, 0.3, -0.3};
+        std::vector<double> innerY = {-0.3, -0.3, 0.3, 0.3};
+        walls.AddPolygon(innerX, innerY);
+        walls.Build(0.25);
+
+        uint32_t const size = 64;
+        CollisionModel collisions(walls, 0.05, CollisionModel::SLIDE, true);
+        Fleet fleet(size, 0.03, 0.12, DifferentialDrive::RK4, 0.001);
+        fleet.SetCollisionModel(&collisions);
+        for (uint32_t i = 0; i < size; i++) {
+            DifferentialPose const pose = {-1.75 + 0.5 * (i % 8), 
+                -1.75 + 0.5 * (i / 8), 0.1 * i};
+            fleet.SetPose(i, pose);
+            fleet.SetWheelAngularVelocities(i, 10.0, 8.0 + 0.05 * i);
+        }
+        // Robots that start inside the inner block are kept there.
+        for (uint32_t j = 0; j < 200; j++) {
+            fleet.Step(0.05);
+        }
+
+        uint32_t wallCollisions = 0;
+        for (uint32_t i = 0; i < size; i++) {
+            DifferentialPose const pose = fleet.GetPose(i);
+            TS_ASSERT(std::abs(pose.x) < 1.95 + 1e-9);
+            TS_ASSERT(std::abs(pose.y) < 1.95 + 1e-9);
+            wallCollisions += collisions.GetWallCollisions(i);
+            for (uint32_t k = i + 1; k < size; k++) {
+                DifferentialPose const other = fleet.GetPose(k);
+                double const distance = std::hypot(pose.x - other.x, 
+                    pose.y - other.y);
+                TS_ASSERT(distance > 0.1 - 1e-9);
+            }
+        }
+        TS_ASSERT(wallCollisions > size / 4);
+    }
+
+    void testMotorModel() {
+        // Servo pulses of 1 to 2 ms, with a deadband of a tenth and a
+        // quadratic curve.
+        MotorModel servo(1000000, 1500000, 2000000, 0.1, 2.0, 10.0, 0.0);
+        TS_ASSERT_DELTA(servo.GetCommand(1500000), 0.0, 1e-12);
+        TS_ASSERT_DELTA(servo.GetCommand(2000000), 1.0, 1e-12);
+        TS_ASSERT_DELTA(servo.GetCommand(1250000), -0.5, 1e-12);
+        TS_ASSERT_DELTA(servo.GetCommand(2500000), 1.0, 1e-12);
+        TS_ASSERT_DELTA(servo.GetCommand(500000), -1.0, 1e-12);
+        TS_ASSERT_DELTA(servo.GetCommand(0), 0.0, 1e-12);
+
+        TS_ASSERT_DELTA(servo.GetAngularVelocity(0.05), 0.0, 1e-12);
+        TS_ASSERT_DELTA(servo.GetAngularVelocity(-0.1), 0.0, 1e-12);
+        TS_ASSERT_DELTA(servo.GetAngularVelocity(0.55), 2.5, 1e-12);
+        TS_ASSERT_DELTA(servo.GetAngularVelocity(-1.0), -10.0, 1e-12);
+        TS_ASSERT_DELTA(servo.GetAngularVelocity(1.5), 10.0, 1e-12);
+
+        // An H-bridge only has a speed, from the minimum width.
+        MotorModel hBridge(25000, 25000, 50000, 0.0, 1.0, 10.0, 0.0);
+        TS_ASSERT_DELTA(hBridge.GetCommand(20000), 0.0, 1e-12);
+        TS_ASSERT_DELTA(hBridge.GetCommand(37500), 0.5, 1e-12);
+        TS_ASSERT_DELTA(hBridge.GetAngularVelocity(
+            -hBridge.GetCommand(37500)), -5.0, 1e-12);
+    }
+
+    void testMotorLag() {
+        Fleet fleet(2, 0.03, 0.12, DifferentialDrive::RK4, 0.001);
+        fleet.SetTimeConstant(0.1);
+        fleet.SetWheelTargets(0, 10.0, 10.0);
+        fleet.SetWheelTargets(1, -4.0, 4.0);
+
+        // After one time constant the wheels are at 1 - 1/e of the target.
+        fleet.Step(0.1);
+        double left;
+        double right;
+        fleet.GetWheelAngularVelocities(0, left, right);
+        TS_ASSERT_DELTA(left, 10.0 * (1.0 - std::exp(-1.0)), 1e-9);
+        TS_ASSERT_DELTA(fleet.GetLinearVelocity(0), 0.03 * left, 1e-12);
+        fleet.GetWheelAngularVelocities(1, left, right);
+        TS_ASSERT_DELTA(right, 4.0 * (1.0 - std::exp(-1.0)), 1e-9);
+
+        // The distance covered lags the distance at once by v * tau.
+        fleet.Step(0.9);
+        double const lag = 0.3 * 1.0 - fleet.GetPose(0).x;
+        TS_ASSERT_DELTA(lag, 0.3 * 0.1 * (1.0 - std::exp(-10.0)), 2e-4);
+
+        fleet.SetTimeConstant(0.0);
+        fleet.SetWheelTargets(0, 0.0, 0.0);
+        fleet.Step(0.001);
+        TS_ASSERT_DELTA(fleet.GetLinearVelocity(0), 0.0, 1e-12);
+    }
+
+    void testFaultsAreSeeded() {
+        FaultModel faults(0.01, 0.02, 0.2, 0.1, 0.05, 0.0, 0.0);
+        std::mt19937 first(42);
+        std::mt19937 second(42);
+        uint32_t dropped = 0;
+        for (uint32_t i = 0; i < 10000; i++) {
+            DifferentialPose a = {1.0, 2.0, 3.1};
+            DifferentialPose b = a;
+            faults.AddPoseNoise(a, first);
+            faults.AddPoseNoise(b, second);
+            TS_ASSERT_EQUALS(a.x, b.x);
+            TS_ASSERT_EQUALS(a.yaw, b.yaw);
+            TS_ASSERT(std::abs(a.yaw) <= M_PI);
+
+            bool const isDropped = faults.IsDropped(first);
+            TS_ASSERT_EQUALS(isDropped, faults.IsDropped(second));
+            dropped += isDropped ? 1 : 0;
+
+            double const delay = faults.GetDelay(first);
+            TS_ASSERT_EQUALS(delay, faults.GetDelay(second));
+            TS_ASSERT(delay >= 0.1 && delay <= 0.15);
+        }
+        TS_ASSERT(dropped > 1800 && dropped < 2200);
+
+        // Without faults nothing is drawn.
+        FaultModel none(0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+        std::mt19937 random(42);
+        DifferentialPose pose = {1.0, 2.0, 3.0};
+        none.AddPoseNoise(pose, random);
+        TS_ASSERT(!none.IsDropped(random));
+        TS_ASSERT_EQUALS(none.GetDelay(random), 0.0);
+        TS_ASSERT_EQUALS(pose.x, 1.0);
+        TS_ASSERT_EQUALS(random(), std::mt19937(42)());
+    }
+
+    void testStuckSensor() {
+        FaultModel faults(0.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.5);
+        std::mt19937 random(1);
+        bool found = true;
+        double distance = 0.3;
+        faults.ApplyStuck(2, 0.0, found, distance, random);
+        TS_ASSERT(faults.IsStuck(2, 0.25));
+        TS_ASSERT(!faults.IsStuck(0, 0.25));
+
+        found = false;
+        distance = 1.0;
+        faults.ApplyStuck(2, 0.25, found, distance, random);
+        TS_ASSERT(found);
+        TS_ASSERT_EQUALS(distance, 0.3);
+        TS_ASSERT(!faults.IsStuck(2, 0.5));
+    }
+
+    void testDelayLineReorders() {
+        DelayLine<uint32_t> line;
+        line.Push(0.3, 1);
+        line.Push(0.1, 2);
+        line.Push(0.2, 3);
+        line.Push(0.1, 4);
+        std::vector<uint32_t> items;
+        line.PopDue(0.05, items);
+        TS_ASSERT(items.empty());
+        line.PopDue(0.2, items);
+        TS_ASSERT_EQUALS(items.size(), 3u);
+        TS_ASSERT_EQUALS(items[0], 2u);
+        TS_ASSERT_EQUALS(items[1], 4u);
+        TS_ASSERT_EQUALS(items[2], 3u);
+        TS_ASSERT_EQUALS(line.GetSize(), 1u);
+    }
+
+    void testCommandQueueBetweenThreads() {
+        CommandQueue queue(64);
+        uint32_t const count = 200000;
+
+        // The producer retries when the queue is full, so nothing is lost
+        // and the commands arrive in order.
+        std::thread producer([&queue, count]() {
+            for (uint32_t i = 0; i < count; i++) {
+                CommandUpdate const update = {CommandUpdate::DUTY_CYCLE, 
+                    i % 7, 1, i};
+                while (!queue.Push(update)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        std::vector<CommandUpdate> updates;
+        uint32_t next = 0;
+        bool inOrder = true;
+        while (next < count) {
+            updates.clear();
+            queue.Drain(updates);
+            for (CommandUpdate const &update : updates) {
+                inOrder = inOrder && (update.value == next) 
+                    && (update.robot == next % 7);
+                next++;
+            }
+        }
+        producer.join();
+        TS_ASSERT(inOrder);
+        TS_ASSERT_EQUALS(next, count);
+
+        // Without a consumer the queue fills up and counts what it drops.
+        CommandQueue full(4);
+        CommandUpdate const update = {CommandUpdate::TOGGLE, 0, 31, 1};
+        for (uint32_t i = 0; i < 6; i++) {
+            full.Push(update);
+        }
+        TS_ASSERT_EQUALS(full.GetDropped(), 2u);
+        updates.clear();
+        TS_ASSERT_EQUALS(full.Drain(updates), 4u);
+        TS_ASSERT(full.Push(update));
+    }
+
+    void testWorldSnapshotRoundtrip() {
+        std::mt19937 random(7);
+        random();
+
+        WorldSnapshot snapshot;
+        snapshot.simulationTime = 12.5;
+        snapshot.SetRandom(random);
+        RobotSnapshot const robot = {0.5, -0.25, 1.0, 3.0, 4.0, 5.0, 6.0, 
+            1500000, 1200000, 0x9};
+        snapshot.robots.push_back(robot);
+        snapshot.robots.push_back(robot);
+        snapshot.robots[1].x = 2.0;
+
+        std::stringstream stream;
+        TS_ASSERT(snapshot.Write(stream));
+        std::string const data = stream.str();
+
+        // The generator takes 624 words and an index, next to 65 bytes per
+        // robot.
+        TS_ASSERT_EQUALS(data.size(), 4u + 4u + 8u + 625u * 4u + 4u 
+            + 2u * 65u);
+
+        WorldSnapshot restored;
+        TS_ASSERT(restored.Read(stream));
+        TS_ASSERT_EQUALS(restored.simulationTime, 12.5);
+        TS_ASSERT_EQUALS(restored.robots.size(), 2u);
+        TS_ASSERT_EQUALS(restored.robots[1].x, 2.0);
+        TS_ASSERT_EQUALS(restored.robots[0].rightTarget, 6.0);
+        TS_ASSERT_EQUALS(restored.robots[0].leftDutyCycleNs, 1500000u);
+        TS_ASSERT_EQUALS(restored.robots[0].gpio, 0x9);
+
+        // The restored generator continues where the saved one stopped.
+        std::mt19937 continued;
+        TS_ASSERT(restored.GetRandom(continued));
+        TS_ASSERT_EQUALS(continued(), random());
+
+        // Truncated data and data of another kind are rejected, and leave
+        // the snapshot as it was.
+        std::istringstream truncated(data.substr(0, data.size() - 1));
+        TS_ASSERT(!restored.Read(truncated));
+        std::string wrongMagic = data;
+        wrongMagic[0] = static_cast<char>(wrongMagic[0] + 1);
+        std::istringstream other(wrongMagic);
+        TS_ASSERT(!restored.Read(other));
+        std::string wrongIndex = data;
+        wrongIndex[16 + 624 * 4 + 1] = static_cast<char>(0x7f);
+        std::istringstream corrupt(wrongIndex);
+        TS_ASSERT(!restored.Read(corrupt));
+        TS_ASSERT_EQUALS(restored.simulationTime, 12.5);
+        TS_ASSERT_EQUALS(restored.robots.size(), 2u);
+        TS_ASSERT(restored.GetRandom(continued));
+    }
+
+    void testFleetContinuesFromSnapshot() {
+        Fleet original(2, 0.03, 0.12, DifferentialDrive::RK4, 0.001);
+        original.SetTimeConstant(0.05);
+        original.SetWheelTargets(0, 8.0, 6.0);
+        original.SetWheelTargets(1, -4.0, 5.0);
+        original.Step(0.03);
+
+        // Save in the middle of the wheels' lag and continue both ways.
+        std::vector<RobotSnapshot> robots;
+        for (uint32_t i = 0; i < 2; i++) {
+            DifferentialPose const pose = original.GetPose(i);
+            RobotSnapshot robot = {pose.x, pose.y, pose.yaw, 0.0, 0.0, 0.0, 
+                0.0, 0, 0, 0};
+            original.GetWheelAngularVelocities(i, robot.leftWheel, 
+                robot.rightWheel);
+            original.GetWheelTargets(i, robot.leftTarget, robot.rightTarget);
+            robots.push_back(robot);
+        }
+
+        Fleet forked(2, 0.03, 0.12, DifferentialDrive::RK4, 0.001);
+        forked.SetTimeConstant(0.05);
+        for (uint32_t i = 0; i < 2; i++) {
+            RobotSnapshot const &robot = robots[i];
+            DifferentialPose const pose = {robot.x, robot.y, robot.yaw};
+            forked.SetPose(i, pose);
+            forked.SetWheelAngularVelocities(i, robot.leftWheel, 
+                robot.rightWheel);
+            forked.SetWheelTargets(i, robot.leftTarget, robot.rightTarget);
+        }
+
+        for (uint32_t step = 0; step < 20; step++) {
+            original.Step(0.01);
+            forked.Step(0.01);
+        }
+        for (uint32_t i = 0; i < 2; i++) {
+            TS_ASSERT_EQUALS(forked.GetPose(i).x, original.GetPose(i).x);
+            TS_ASSERT_EQUALS(forked.GetPose(i).y, original.GetPose(i).y);
+            TS_ASSERT_EQUALS(forked.GetPose(i).yaw, original.GetPose(i).yaw);
+        }
+    }
+
+    void testTickCountersHistograms() {
+        // Ten bins of 10 ms over two periods of 50 ms.
+        TickCounters counters(0.05, 10);
+        TS_ASSERT_DELTA(counters.GetBinWidth(), 0.01, 1e-12);
+        for (uint32_t i = 0; i < 98; i++) {
+            counters.AddTick(0.012, 0.038);
+        }
+        counters.AddTick(0.06, 0.0);
+        counters.AddTick(0.5, 0.0);
+        counters.AddMessagesIn(3);
+        counters.AddMessagesOut(5);
+
+        TS_ASSERT_EQUALS(counters.GetTicks(), 100u);
+        TS_ASSERT_EQUALS(counters.GetOverruns(), 2u);
+        TS_ASSERT_EQUALS(counters.GetMessagesIn(), 3u);
+        TS_ASSERT_EQUALS(counters.GetMessagesOut(), 5u);
+        TS_ASSERT_DELTA(counters.GetMaxComputeTime(), 0.5, 1e-12);
+        TS_ASSERT_DELTA(counters.GetMeanWaitTime(), 0.98 * 0.038, 1e-12);
+        TS_ASSERT_EQUALS(counters.GetComputeTimes()[1], 98u);
+        TS_ASSERT_EQUALS(counters.GetComputeTimes()[6], 1u);
+        TS_ASSERT_EQUALS(counters.GetComputeTimes()[9], 1u);
+        TS_ASSERT_EQUALS(counters.GetWaitTimes()[0], 2u);
+        TS_ASSERT_EQUALS(counters.GetWaitTimes()[3], 98u);
+        TS_ASSERT_DELTA(counters.GetComputeTimePercentile(0.5), 0.02, 1e-12);
+        TS_ASSERT_DELTA(counters.GetComputeTimePercentile(0.99), 0.07, 1e-12);
+        TS_ASSERT_DELTA(counters.GetComputeTimePercentile(1.0), 0.5, 1e-12);
+
+        std::ostringstream csv;
+        counters.WriteCsv(csv, 5.0);
+        TS_ASSERT_EQUALS(csv.str().substr(0, 15), "5,100,2,3,5,0.0");
+
+        counters.Reset();
+        TS_ASSERT_EQUALS(counters.GetTicks(), 0u);
+        TS_ASSERT_EQUALS(counters.GetComputeTimes()[1], 0u);
+        TS_ASSERT_EQUALS(counters.GetMeanComputeTime(), 0.0);
+    }
+
+    void testTickCountersMeasureWait() {
+        // A 10 ms period, so that a 20 ms tick is an overrun.
+        TickCounters counters(0.01, 20);
+        counters.BeginTick();
+        counters.EndTick();
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        counters.BeginTick();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        counters.EndTick();
+
+        TS_ASSERT_EQUALS(counters.GetTicks(), 2u);
+        TS_ASSERT_EQUALS(counters.GetOverruns(), 1u);
+        TS_ASSERT(counters.GetMaxComputeTime() >= 0.02);
+        TS_ASSERT(counters.GetMeanWaitTime() >= 0.0025);
+        TS_ASSERT_EQUALS(counters.GetComputeTimes().back(), 1u);
+    }
 };
 
 #endif